@@ -27,56 +27,469 @@
 #include <poll.h>
 #include <fcntl.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <getopt.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Global defines
 #define SERVER_ENABLED          0x01
 #define SERVER_SIGUSR1          0x02
 #define SERVER_SIGTERM          0x04
+#define SERVER_SIGHUP           0x08
+#define SERVER_SIGUSR2          0x10
 #define SOCKETERR               -1
 #define ERROR                   1
 #define SUCCESS                 0
 #define THREAD_POOL_SIZE        8
 #define MAXREQUESTSIZE          4096
 #define REQUEST_FIELDS          3
+#define REQUEST_MAX_FIELDS      4
+#define REQUEST_GET             0
+#define REQUEST_STATS           1
+#define REQUEST_TOPK            2
+#define REQUEST_DUMP            3
+#define CACHE_SHARD_NUMBER      16
+#define CACHE_MIN_SHARD_SIZE    64
+#define CACHE_RESIZE_HEADROOM   4
+#define CACHE_EVICT_BATCH       64
+#define CACHE_LINE_SIZE         64
+#define MD5_STRING_SIZE         33
+#define MD5_DIGEST_SIZE         16
+#define CACHE_INLINE_KEY_SIZE   24
+#define CACHE_NIL               0
+#define CACHE_PREFETCH_BATCH    16
+#define CACHE_HUGE_PAGE_SIZE    (2 << 20)
+#define CACHE_PAGES_SMALL       0
+#define CACHE_PAGES_TRANSPARENT 1
+#define CACHE_PAGES_EXPLICIT    2
+#define RECENCY_BUFFER_SIZE     32
+#define RECENCY_FLUSH_MS        100
+#define EPOCH_MAX_THREADS       1024
+#define EPOCH_RECLAIM_THRESHOLD 64
+#define EPOCH_WAIT_US           1000
+#define CACHE_STATS_MAX_THREADS 1024
+#define HEAVY_HITTERS_SIZE      256
+#define HEAVY_HITTERS_LOCAL_SIZE 64
+#define HEAVY_HITTERS_MERGE_COUNT 1024
+#define HEAVY_HITTERS_MERGE_MS  1000
+#define HEAVY_HITTERS_DECAY_MS  60000
+#define HEAVY_HITTERS_DEFAULT_K 10
+#define HEAVY_HITTERS_KEY_SIZE  64
+#define NEAR_CACHE_SLOTS        512
+#define NEAR_CACHE_REFRESH      16
+#define TINYLFU_SKETCH_ROWS     4
+#define TINYLFU_MAX_COUNT       15
+#define TINYLFU_SAMPLE_FACTOR   10
+#define TINYLFU_DOORKEEPER_HASHES 3
+#define CACHE_POLICY_QUEUES     2
+#define S3FIFO_SMALL_RATIO      10
+#define S3FIFO_MAX_FREQUENCY    3
+#define TTL_WHEEL_SLOTS         512
+#define TTL_WHEEL_TICK_MS       100
+#define INFLIGHT_TABLE_STRIPES  64
+#define SNAPSHOT_MAGIC          "METEOSNP"
+#define SNAPSHOT_VERSION        1
+#define CACHE_DUMP_CHUNK        256
+#define CACHE_DUMP_BUFFER_SIZE  (64 << 10)
+#define CACHE_DUMP_LINE_SIZE    64
+#define INSERT_LOG_BUFFER_SIZE  (4 << 20)
+#define INSERT_LOG_FLUSH_MS     10
+#define INSERT_LOG_SYNC_MS      1000
+#define INSERT_LOG_COMPACT_BYTES (64 << 20)
+#define INSERT_LOG_CHECK_MS     1000
+#define DISK_TIER_MAGIC         "METEODSK"
+#define DISK_TIER_HEADER_SIZE   4096
+#define DISK_TIER_KEY_SIZE      88
+#define DISK_TIER_BUCKET_SLOTS  8
+#define DISK_TIER_STRIPES       256
+#define DISK_TIER_DEMOTE_BATCH  8
 
 // Formatting
 #define SEND_TIMEOUT            "Timeout.\n"
 #define SEND_LONG_REQUEST       "Request is too long.\n"
 #define SEND_INVALID_REQUEST    "Request is not valid.\n"
+#define SEND_STATS_SIZE         1024
 
 // Useful macros
 #define print_error()           fprintf(stderr, "Error '%d': '%s'", errno, strerror(errno))
 #define safe_free(x)            if(x){free(x);x=NULL;}
 #define check_socket_error(x)   if(x == SOCKETERR){print_error();exit(ERROR);} x;
 
+// Atomic accesses to data shared with the lock-free read path
+#define load_relaxed(x)         __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define load_acquire(x)         __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define store_relaxed(x, v)     __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define store_release(x, v)     __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+// Counts cache operations in the record of the calling thread, which is the only one writing to it
+#define cache_stats_add(field, n)   do { cacheStats_t *self = cache_stats_thread(); \
+                                         store_relaxed(self->field, self->field + (n)); } while (0)
+
 // Global flag in charge of keeping track of the server state
 extern volatile sig_atomic_t serverHandler;
 
 
-// Struct containing an individual node of the LRU cache
+// Nodes of a shard: links are 32-bit indices into its pool, whose first node (CACHE_NIL) is never used
+#define cache_node(shard, index)        (&((shard)->cachePool[index]))
+#define cache_node_index(shard, node)   ((uint32_t)((node) - (shard)->cachePool))
+#define cache_node_data(shard, node)    (&((shard)->nodeData[(node) - (shard)->cachePool]))
+
+// Hot metadata of an individual node of the LRU cache, walked by the lookups and the eviction policies
 typedef struct          lruCacheNode
 {
-	char                *request;
-    char                *md5;
-    struct lruCacheNode *next;
-    struct lruCacheNode *prev;
-}                       lruCacheNode_t;
+    uint64_t            hash;
+    uint32_t            seq;
+    uint32_t            requestLength;
+    uint32_t            hashNext;
+    uint32_t            next;
+    uint32_t            prev;
+    uint8_t             frequency;
+    uint8_t             queue;
+    bool                used;
+}                       __attribute__((aligned(32))) lruCacheNode_t;
 
-// General struct for LRU cache
-typedef struct          lruCache
+// Cold data of an individual node of the LRU cache, only read once its hot metadata matches a lookup
+typedef struct          lruCacheNodeData
+{
+    char                *request;
+    uint64_t            md5[MD5_DIGEST_SIZE / sizeof(uint64_t)];
+    uint64_t            expiry;
+    uint32_t            wheelNext;
+    uint32_t            wheelPrev;
+    char                inlineRequest[CACHE_INLINE_KEY_SIZE];
+}                       __attribute__((aligned(CACHE_LINE_SIZE))) lruCacheNodeData_t;
+
+// TinyLFU frequency filter: count-min sketch of 4-bit counters, two per byte, plus a doorkeeper bloom filter
+typedef struct          tinyLfu
+{
+    uint8_t             *sketch;
+    size_t              sketchMask;
+    uint64_t            *doorkeeper;
+    size_t              doorkeeperMask;
+    size_t              additions;
+    size_t              sampleSize;
+}                       tinyLfu_t;
+
+// FIFO/LRU queue of the hashes of recently evicted requests, used by the ARC and S3-FIFO policies
+typedef struct          ghostEntry
+{
+    uint64_t            hash;
+    uint32_t            next;
+    uint32_t            prev;
+    uint32_t            hashNext;
+}                       ghostEntry_t;
+
+typedef struct          ghostQueue
+{
+    ghostEntry_t        *entries;
+    uint32_t            *buckets;
+    size_t              bucketMask;
+    uint32_t            freeList;
+    size_t              size;
+    size_t              capacity;
+}                       ghostQueue_t;
+
+// Per-shard state of the ARC policy: target size of T1 and the ghost lists B1 and B2
+typedef struct          arcState
+{
+    size_t              target;
+    ghostQueue_t        *ghosts[2];
+}                       arcState_t;
+
+// Per-shard state of the S3-FIFO policy: ghost queue of the requests evicted from the small queue
+typedef struct          s3FifoState
+{
+    ghostQueue_t        *ghost;
+}                       s3FifoState_t;
+
+// Slot of the disk tier, holding an element evicted from memory. Stale when its generation isn't the one of the tier
+typedef struct          diskTierSlot
+{
+    uint64_t            hash;
+    uint64_t            expiry;
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    uint32_t            generation;
+    uint32_t            length;
+    char                request[DISK_TIER_KEY_SIZE];
+}                       diskTierSlot_t;
+
+// Header of the disk tier file, followed by its buckets from the first page on
+typedef struct          diskTierHeader
+{
+    char                magic[8];
+    uint32_t            generation;
+    uint32_t            slotSize;
+    uint64_t            buckets;
+}                       diskTierHeader_t;
+
+// Second tier of the cache: hash table of DISK_TIER_BUCKET_SLOTS-slot buckets in a memory-mapped file
+typedef struct          diskTier
 {
-    lruCacheNode_t      *head;
-    lruCacheNode_t      **cachePool;
+    diskTierHeader_t    *header;
+    diskTierSlot_t      *slots;
+    size_t              bucketMask;
+    size_t              mapSize;
+    uint64_t            cacheGeneration;
+    pthread_mutex_t     locks[DISK_TIER_STRIPES];
+}                       diskTier_t;
+
+// Independent cache shard, with its own policy queues, hash index and lock
+typedef struct          lruCacheShard
+{
+    lruCacheNode_t      *queues[CACHE_POLICY_QUEUES];
+    size_t              queueSizes[CACHE_POLICY_QUEUES];
+    lruCacheNode_t      *cachePool;
+    lruCacheNodeData_t  *nodeData;
+    uint32_t            freeNodes;
+    size_t              poolUsed;
+    size_t              poolCapacity;
+    uint32_t            *hashTable;
+    size_t              hashMask;
+    size_t              clockHand;
+    uint32_t            *timingWheel;
+    uint64_t            wheelTick;
+    size_t              expiringCount;
+    void                *policyData;
+    tinyLfu_t           *admission;
     pthread_mutex_t     mutex;
     size_t              currentCapacity;
     size_t              totalCapacity;
+    size_t              usedBytes;
+    size_t              byteCapacity;
+    bool                hugePages;
+    int                 pageBacking;
+}                       __attribute__((aligned(CACHE_LINE_SIZE))) lruCacheShard_t;
+
+// Eviction policy of the cache. Every callback but 'touch' runs under the shard lock
+typedef struct          cachePolicy
+{
+    const char          *name;
+    void                (*init)(lruCacheShard_t *shard);
+    void                (*free)(lruCacheShard_t *shard);
+    void                (*touch)(lruCacheNode_t *node);
+    void                (*hit)(lruCacheShard_t *shard, lruCacheNode_t *node);
+    void                (*insert)(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+    lruCacheNode_t      *(*victim)(lruCacheShard_t *shard, uint64_t hash);
+    void                (*remove)(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+    lruCacheNode_t      *(*next)(lruCacheShard_t *shard, lruCacheNode_t *node);
+}                       cachePolicy_t;
+
+// General struct for LRU cache, split in shards chosen by the hash of the request
+typedef struct          lruCache
+{
+    lruCacheShard_t     *shards;
+    size_t              shardNumber;
+    size_t              totalCapacity;
+    size_t              totalBytes;
+    uint64_t            generation;
+    const cachePolicy_t *policy;
+    unsigned int        defaultTtl;
+    bool                shrinking;
+    int                 pageBacking;
+    diskTier_t          *diskTier;
 }                       lruCache_t;
 
+// Cache hit whose recency update has been deferred
+typedef struct          recencyEntry
+{
+    uint64_t            generation;
+    uint64_t            hash;
+    lruCacheNode_t      *node;
+    uint32_t            shard;
+    uint32_t            seq;
+}                       recencyEntry_t;
+
+// Per-thread buffer of deferred recency updates, applied to the shards in batches
+typedef struct          recencyBuffer
+{
+    recencyEntry_t      entries[RECENCY_BUFFER_SIZE];
+    size_t              count;
+    uint64_t            since;
+}                       recencyBuffer_t;
+
+// Slot of a near cache, holding the digest of a request served by its thread
+typedef struct          nearCacheSlot
+{
+    uint64_t            hash;
+    uint64_t            generation;
+    uint64_t            expiry;
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    char                *request;
+    uint32_t            size;
+    uint32_t            hits;
+}                       __attribute__((aligned(CACHE_LINE_SIZE))) nearCacheSlot_t;
+
+// Direct-mapped near cache of a thread of the pool, in front of the shared cache
+typedef struct          nearCache
+{
+    nearCacheSlot_t     slots[NEAR_CACHE_SLOTS];
+}                       nearCache_t;
+
+// Pointer retired from a shared structure, pending to be freed
+typedef struct          epochRetired
+{
+    void                *ptr;
+    uint64_t            epoch;
+}                       epochRetired_t;
+
+// Per-thread record of the epoch-based reclamation
+typedef struct          epochThread
+{
+    uint64_t            active;
+    uint32_t            id;
+    uint32_t            depth;
+    bool                claimed;
+    epochRetired_t      *retired;
+    size_t              retiredCount;
+    size_t              retiredSize;
+}                       __attribute__((aligned(CACHE_LINE_SIZE))) epochThread_t;
+
+// Per-thread counters of the cache operations, in cache lines of their own
+typedef struct          cacheStats
+{
+    uint64_t            hits;
+    uint64_t            misses;
+    uint64_t            tierHits;
+    uint64_t            inserts;
+    uint64_t            rejections;
+    uint64_t            evictions;
+    uint64_t            expirations;
+    uint64_t            demotions;
+    uint64_t            nearHits;
+    bool                claimed;
+}                       __attribute__((aligned(CACHE_LINE_SIZE))) cacheStats_t;
+
+// Cache miss being computed by its leader, awaited by the threads that missed the same request
+typedef struct          inflightEntry
+{
+    char                *request;
+    uint64_t            hash;
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    bool                done;
+    unsigned int        waiters;
+    pthread_cond_t      published;
+    struct inflightEntry *next;
+}                       inflightEntry_t;
+
+// Stripe of the in-flight table, with its own lock
+typedef struct          inflightStripe
+{
+    inflightEntry_t     *entries;
+    pthread_mutex_t     mutex;
+}                       __attribute__((aligned(CACHE_LINE_SIZE))) inflightStripe_t;
+
+// Table of the cache misses being computed, split in stripes chosen by the hash of the request
+typedef struct          inflightTable
+{
+    inflightStripe_t    stripes[INFLIGHT_TABLE_STRIPES];
+}                       inflightTable_t;
+
+// Request monitored by a Space-Saving summary, with the possible overestimation of its count
+typedef struct          heavyHitter
+{
+    uint64_t            hash;
+    uint64_t            count;
+    uint64_t            error;
+    char                *request;
+    size_t              capacity;
+}                       heavyHitter_t;
+
+// Global Space-Saving summary of the most requested keys, fed by the summaries of the threads
+typedef struct          heavyHitters
+{
+    heavyHitter_t       entries[HEAVY_HITTERS_SIZE];
+    size_t              used;
+    uint64_t            lastDecay;
+    pthread_key_t       local;
+    pthread_mutex_t     mutex;
+}                       heavyHitters_t;
+
+// Space-Saving summary of a single thread, merged into the global one in batches
+typedef struct          heavyHittersLocal
+{
+    heavyHitters_t      *table;
+    heavyHitter_t       entries[HEAVY_HITTERS_LOCAL_SIZE];
+    size_t              used;
+    size_t              pending;
+    uint64_t            lastMerge;
+}                       heavyHittersLocal_t;
+
+// Header of a snapshot file, followed by the elements of each shard from the least to the most recently used.
+// The number of shards is only informative, the elements are hashed again when they're restored
+typedef struct          snapshotHeader
+{
+    char                magic[8];
+    uint32_t            version;
+    uint32_t            shardNumber;
+    uint64_t            elements;
+}                       snapshotHeader_t;
+
+// Element of a snapshot file, followed by its request and a NUL byte. Packed, so elements are stored back to back
+typedef struct          snapshotEntry
+{
+    uint64_t            expiresAt;
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    uint32_t            length;
+}                       __attribute__((packed)) snapshotEntry_t;
+
+// Range of a warm-up file, whose keys are inserted into the cache by a thread of its own
+typedef struct          cacheWarmRange
+{
+    lruCache_t          *cache;
+    char                *begin;
+    char                *end;
+    size_t              warmed;
+}                       cacheWarmRange_t;
+
+// Record of the insert log: an element in the format of a snapshot, after the checksum of the element and its request
+typedef struct          insertLogRecord
+{
+    uint64_t            checksum;
+    snapshotEntry_t     entry;
+}                       __attribute__((packed)) insertLogRecord_t;
+
+// Append-only log of the inserted elements, written in batches by its own thread
+typedef struct          insertLog
+{
+    char                *buffer;
+    char                *spare;
+    size_t              used;
+    size_t              pausedAt;
+    size_t              size;
+    size_t              dropped;
+    uint64_t            generation;
+    int                 fd;
+    bool                paused;
+    bool                writing;
+    bool                stopped;
+    pthread_t           writer;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      wake;
+    pthread_cond_t      written;
+}                       insertLog_t;
+
 // Struct to keep track of the command line arguments
 typedef struct          arguments {
     int                 cacheSize;
     int                 port;
     int                 threadNumber;
+    int                 shardNumber;
+    const cachePolicy_t *policy;
+    bool                admission;
+    unsigned int        ttl;
+    size_t              cacheBytes;
+    bool                sizeFromBudget;
+    char                *configFile;
+    char                *snapshotFile;
+    char                *logFile;
+    char                *diskTierFile;
+    size_t              diskTierBytes;
+    bool                dumpOnly;
+    bool                hugePages;
+    char                *warmFile;
 }                       arguments_t;
 
 // Struct that contains an individual node of the linked queue
@@ -97,8 +510,12 @@ typedef struct          linked_queue_t {
 
 // Struct that contains data from a client request
 typedef struct          request {
+    int                 command;
+    unsigned int        count;
     char                *msg;
+    uint64_t            hash;
     time_t              mseconds;
+    unsigned int        ttl;
 }                       request_t;
 
 // Struct used by the MD5 algorithm
@@ -113,10 +530,21 @@ typedef struct          MD5Context {
 typedef struct          serverState {
     linked_queue_t      *requestQueue;
     lruCache_t          *lruCache;
+    inflightTable_t     *inflightTable;
+    heavyHitters_t      *heavyHitters;
+    insertLog_t         *insertLog;
+    diskTier_t          *diskTier;
     arguments_t         settings;
     pthread_t           *thread_pool;
+    pthread_t           sweeper;
+    pthread_t           maintainer;
     pthread_mutex_t     queueMutex;
+    pthread_mutex_t     cacheMutex;
+    pthread_cond_t      maintenanceRequested;
+    bool                flushPending;
+    bool                snapshotPending;
     int                 serverSocket;
+    uint64_t            startTime;
 }                       serverState_t;
 
 
@@ -126,6 +554,7 @@ typedef struct          serverState {
 void                *request_monitor(void *state);
 void                signal_modifier();
 void                empty_cache(serverState_t *state);
+void                snapshot_cache(serverState_t *state);
 void                setup_server_networking(serverState_t *state);
 
 // MD5-related definitions
@@ -133,13 +562,122 @@ uint32_t            F(uint32_t X, uint32_t Y, uint32_t Z);
 uint32_t            G(uint32_t X, uint32_t Y, uint32_t Z);
 uint32_t            H(uint32_t X, uint32_t Y, uint32_t Z);
 uint32_t            I(uint32_t X, uint32_t Y, uint32_t Z);
+void                md5Digest(char *input, uint8_t *digest);
+void                md5ToHex(uint8_t *digest, char *output);
 char               *md5String(char *input);
 
 // LRU cache-related definitions
-lruCache_t          *lru_cache_init(int capacity);
-char                *lru_cache_get_element(lruCache_t *cache, char *request);
-void                lru_cache_update_node(lruCache_t *cache, char *request, char *value);
+uint64_t            lru_hash_request(char *request);
+uint64_t            lru_clock_ms();
+size_t              lru_entry_size(size_t requestLength);
+lruCache_t          *lru_cache_init(arguments_t *settings);
+uint8_t             *lru_cache_get_element(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5,
+                                          uint64_t *expiry);
+uint8_t             *lru_cache_peek_element(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5,
+                                           uint64_t *expiry);
+size_t              lru_cache_get_many(lruCache_t *cache, char **requests, uint64_t *hashes, size_t count,
+                                       uint8_t *md5s, bool *found);
+bool                lru_cache_update_node(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, unsigned int ttl,
+                                          uint64_t *expiry);
+bool                lru_cache_restore_node(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t expiry);
+void                lru_cache_expire(lruCache_t *cache);
+size_t              lru_cache_resize(lruCache_t *cache, size_t capacity, size_t bytes);
+bool                lru_cache_trim(lruCache_t *cache);
 void                lru_cache_free(lruCache_t *cache);
+void                lru_cache_usage(lruCache_t *cache, size_t *elements, size_t *bytes);
+const char          *lru_cache_page_backing(lruCache_t *cache);
+void                lru_cache_drain_recency(lruCache_t *cache);
+
+// Cache policy-related definitions
+extern const cachePolicy_t  lruPolicy;
+extern const cachePolicy_t  clockPolicy;
+extern const cachePolicy_t  arcPolicy;
+extern const cachePolicy_t  s3FifoPolicy;
+const cachePolicy_t *cache_policy_find(char *name);
+size_t              cache_policy_capacity(lruCacheShard_t *shard);
+void                cache_queue_push(lruCacheShard_t *shard, uint8_t queue, lruCacheNode_t *node);
+void                cache_queue_unlink(lruCacheShard_t *shard, lruCacheNode_t *node);
+lruCacheNode_t      *cache_queue_tail(lruCacheShard_t *shard, uint8_t queue);
+lruCacheNode_t      *cache_queue_next(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+// Ghost queue-related definitions
+ghostQueue_t        *ghost_queue_init(size_t capacity);
+void                ghost_queue_free(ghostQueue_t *ghost);
+void                ghost_queue_push(ghostQueue_t *ghost, uint64_t hash);
+bool                ghost_queue_remove(ghostQueue_t *ghost, uint64_t hash);
+bool                ghost_queue_contains(ghostQueue_t *ghost, uint64_t hash);
+void                ghost_queue_pop(ghostQueue_t *ghost);
+
+// TinyLFU-related definitions
+tinyLfu_t           *tiny_lfu_init(size_t capacity);
+void                tiny_lfu_free(tinyLfu_t *lfu);
+void                tiny_lfu_increment(tinyLfu_t *lfu, uint64_t hash);
+unsigned int        tiny_lfu_estimate(tinyLfu_t *lfu, uint64_t hash);
+
+// Snapshot-related definitions
+uint64_t            cache_snapshot_clock_ms();
+bool                cache_snapshot_write(int fd, const void *buffer, size_t size);
+bool                cache_snapshot_save(lruCache_t *cache, char *path);
+bool                cache_snapshot_load(lruCache_t *cache, char *path, size_t *restored);
+
+// Dump-related definitions
+bool                cache_dump(lruCache_t **cache, int fd);
+
+// Warm-up-related definitions
+bool                cache_warm(lruCache_t *cache, char *path, int threads, size_t *warmed);
+
+// Insert log-related definitions
+insertLog_t         *insert_log_open(char *path, lruCache_t *cache, size_t *replayed);
+void                insert_log_close(insertLog_t *log);
+void                insert_log_append(insertLog_t *log, char *request, uint8_t *md5, unsigned int ttl,
+                                      uint64_t generation);
+size_t              insert_log_size(insertLog_t *log);
+void                insert_log_pause(insertLog_t *log, uint64_t generation);
+void                insert_log_resume(insertLog_t *log, bool truncate);
+
+// Disk tier-related definitions
+diskTier_t          *disk_tier_open(char *path, size_t bytes);
+void                disk_tier_close(diskTier_t *tier);
+bool                disk_tier_stage(diskTierSlot_t *slot, char *request, size_t length, uint64_t hash, uint8_t *md5,
+                                    uint64_t expiry);
+void                disk_tier_put(diskTier_t *tier, diskTierSlot_t *slot, uint64_t generation);
+bool                disk_tier_take(diskTier_t *tier, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry);
+void                disk_tier_clear(diskTier_t *tier, uint64_t generation);
+size_t              disk_tier_capacity(diskTier_t *tier);
+
+// In-flight table-related definitions
+inflightTable_t     *inflight_table_init();
+void                inflight_table_free(inflightTable_t *table);
+inflightEntry_t     *inflight_table_acquire(inflightTable_t *table, char *request, uint64_t hash, uint8_t *md5);
+void                inflight_table_publish(inflightTable_t *table, inflightEntry_t *entry, uint8_t *md5);
+
+// Near cache-related definitions
+nearCache_t         *near_cache_init();
+void                near_cache_free(nearCache_t *nearCache);
+bool                near_cache_get(nearCache_t *nearCache, char *request, uint64_t hash, uint64_t generation,
+                                   uint8_t *md5);
+void                near_cache_put(nearCache_t *nearCache, char *request, uint64_t hash, uint64_t generation,
+                                   uint8_t *md5, uint64_t expiry);
+
+// Heavy hitters-related definitions
+heavyHitters_t      *heavy_hitters_init();
+void                heavy_hitters_free(heavyHitters_t *table);
+void                heavy_hitters_record(heavyHitters_t *table, char *request, uint64_t hash);
+size_t              heavy_hitters_top(heavyHitters_t *table, heavyHitter_t *top, size_t k);
+
+// Epoch-related definitions
+epochThread_t       *epoch_thread();
+void                epoch_unregister();
+void                epoch_enter();
+void                epoch_exit();
+void                epoch_retire(void *ptr);
+void                epoch_synchronize();
+void                epoch_free_all();
+
+// Cache statistics-related definitions
+cacheStats_t        *cache_stats_thread();
+void                cache_stats_unregister();
+void                cache_stats_read(cacheStats_t *total);
 
 // Queue-related definitions
 linked_queue_t      *linked_queue_init();
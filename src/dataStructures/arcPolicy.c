@@ -0,0 +1,200 @@
+/*
+ * [meteoserver]
+ * arcPolicy.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Adaptive Replacement Cache, applied to each shard independently:
+ *   - T1 (queue 0) holds the requests seen once recently and T2 (queue 1) the ones seen at
+ *     least twice. A hit moves its node to the head of T2.
+ *   - B1 and B2 keep only the hashes of the requests evicted from T1 and T2. A miss found in
+ *     one of them moves the target size of T1 towards the list that would have kept it.
+ *   - The adaptation is done when the request is inserted, right after its victim has been
+ *     evicted, instead of before choosing the victim as in the original algorithm.
+ */
+
+
+/**
+* @brief Drops the oldest ghosts until B1 fits next to T1 and both ghost lists fit next to the cache.
+* @param shard Shard whose ghosts are trimmed.
+* @param arc ARC state of the shard.
+*/
+static void arc_policy_trim(lruCacheShard_t *shard, arcState_t *arc);
+
+/**
+* @brief Allocs the ARC state of a shard.
+* @param shard Shard to be initialized.
+*/
+static void arc_policy_init(lruCacheShard_t *shard);
+
+/**
+* @brief Frees the ARC state of a shard.
+* @param shard Shard to be freed.
+*/
+static void arc_policy_free(lruCacheShard_t *shard);
+
+/**
+* @brief Moves a hit node to the head of T2.
+* @param shard Shard that contains the node.
+* @param node Node that has been hit.
+*/
+static void arc_policy_hit(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief Inserts a new node in T1, or in T2 when its request was found in a ghost list.
+* @param shard Shard that contains the node.
+* @param node Node to be inserted.
+* @param hash Hash of the request of the node.
+*/
+static void arc_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+/**
+* @brief Chooses the oldest node of T1 when it's over its target size, the oldest one of T2 otherwise.
+* @param shard Shard whose node will be evicted.
+* @param hash Hash of the request that will replace the victim.
+* @return Node to be evicted.
+*/
+static lruCacheNode_t *arc_policy_victim(lruCacheShard_t *shard, uint64_t hash);
+
+/**
+* @brief Unlinks an evicted node and remembers its request in the ghost list of its queue.
+* @param shard Shard that contains the node.
+* @param node Node to be evicted.
+* @param hash Hash of the request of the node.
+*/
+static void arc_policy_remove(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+
+
+/* Policy */
+
+
+const cachePolicy_t arcPolicy = {
+    .name = "arc",
+    .init = arc_policy_init,
+    .free = arc_policy_free,
+    .touch = NULL,
+    .hit = arc_policy_hit,
+    .insert = arc_policy_insert,
+    .victim = arc_policy_victim,
+    .remove = arc_policy_remove,
+    .next = cache_queue_next
+};
+
+
+
+/* Definitions */
+
+
+// Drops the oldest ghosts until B1 fits next to T1 and both ghost lists fit next to the cache
+static void arc_policy_trim(lruCacheShard_t *shard, arcState_t *arc)
+{
+    size_t capacity = cache_policy_capacity(shard);
+
+    while (arc->ghosts[0]->size && shard->queueSizes[0] + arc->ghosts[0]->size > capacity)
+        ghost_queue_pop(arc->ghosts[0]);
+
+    while (arc->ghosts[1]->size && shard->queueSizes[0] + shard->queueSizes[1] +
+           arc->ghosts[0]->size + arc->ghosts[1]->size > 2 * capacity)
+        ghost_queue_pop(arc->ghosts[1]);
+}
+
+// Allocs the ARC state of a shard
+static void arc_policy_init(lruCacheShard_t *shard)
+{
+    arcState_t *arc = calloc(1, sizeof(arcState_t));
+
+    arc->target = 0;
+    arc->ghosts[0] = ghost_queue_init(shard->totalCapacity);
+    arc->ghosts[1] = ghost_queue_init(shard->totalCapacity);
+    shard->policyData = arc;
+}
+
+// Frees the ARC state of a shard
+static void arc_policy_free(lruCacheShard_t *shard)
+{
+    arcState_t *arc = shard->policyData;
+
+    if (arc)
+    {
+        ghost_queue_free(arc->ghosts[0]);
+        ghost_queue_free(arc->ghosts[1]);
+        safe_free(shard->policyData);
+    }
+}
+
+// Moves a hit node to the head of T2
+static void arc_policy_hit(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    if (shard->queues[1] == node)
+        return;
+
+    cache_queue_unlink(shard, node);
+    cache_queue_push(shard, 1, node);
+}
+
+// Inserts a new node in T1, or in T2 when its request was found in a ghost list
+static void arc_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    arcState_t  *arc = shard->policyData;
+    size_t      b1 = arc->ghosts[0]->size;
+    size_t      b2 = arc->ghosts[1]->size;
+    size_t      delta;
+
+    // A miss in B1 means T1 was too small: grow its target
+    if (ghost_queue_remove(arc->ghosts[0], hash))
+    {
+        delta = b2 > b1 ? b2 / b1 : 1;
+        arc->target = arc->target + delta < cache_policy_capacity(shard) ? arc->target + delta
+                                                                          : cache_policy_capacity(shard);
+        cache_queue_push(shard, 1, node);
+    }
+    // A miss in B2 means T2 was too small: shrink the target of T1
+    else if (ghost_queue_remove(arc->ghosts[1], hash))
+    {
+        delta = b1 > b2 ? b1 / b2 : 1;
+        arc->target = arc->target > delta ? arc->target - delta : 0;
+        cache_queue_push(shard, 1, node);
+    }
+    else
+        cache_queue_push(shard, 0, node);
+
+    arc_policy_trim(shard, arc);
+}
+
+// Chooses the oldest node of T1 when it's over its target size, the oldest one of T2 otherwise
+static lruCacheNode_t *arc_policy_victim(lruCacheShard_t *shard, uint64_t hash)
+{
+    arcState_t  *arc = shard->policyData;
+    size_t      t1 = shard->queueSizes[0];
+
+    if (t1 && (t1 > arc->target || !shard->queues[1] ||
+               (t1 == arc->target && ghost_queue_contains(arc->ghosts[1], hash))))
+        return cache_queue_tail(shard, 0);
+
+    return cache_queue_tail(shard, 1);
+}
+
+// Unlinks an evicted node and remembers its request in the ghost list of its queue
+static void arc_policy_remove(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    arcState_t *arc = shard->policyData;
+
+    if (!node->next)
+        return;
+
+    ghost_queue_push(arc->ghosts[node->queue], hash);
+    cache_queue_unlink(shard, node);
+    arc_policy_trim(shard, arc);
+}
@@ -0,0 +1,171 @@
+/*
+ * [meteoserver]
+ * cacheDump.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Human-readable dump of the cached elements, one "Request: '...' with hash: '...'" line each:
+ *   - The pool of each shard is walked in chunks of CACHE_DUMP_CHUNK nodes. A shard is only
+ *     locked while a chunk is formatted, so the inserts into it wait for one chunk at most.
+ *   - Chunks are formatted into a buffer of CACHE_DUMP_BUFFER_SIZE bytes, which is written
+ *     once the shard is released: a slow reader never holds a lock.
+ *   - The cache is only pinned while a chunk is formatted, so a slow reader doesn't hold back
+ *     the reclamation of memory nor a flush either. The cache is loaded again for every chunk,
+ *     and the dump ends when a flush has replaced it.
+ *   - Nodes keep their place in the pool, so walking it by index survives the changes made
+ *     between chunks. Elements inserted or evicted meanwhile may be missed, but none is listed twice.
+ *   - Expired elements are left out. The order is the one of the pool, not the one of the policy.
+ */
+
+
+/**
+* @brief Formats a chunk of the pool of a shard into a buffer, under the shard lock.
+* @param shard Shard to be dumped.
+* @param position Index of the first node of the chunk, moved past the last node formatted.
+* @param buffer Buffer of CACHE_DUMP_BUFFER_SIZE bytes.
+* @return Number of bytes formatted into the buffer.
+*/
+static size_t cache_dump_chunk(lruCacheShard_t *shard, size_t *position, char *buffer);
+
+/**
+* @brief Writes a whole buffer to a socket or a file, retrying the partial writes.
+* @param fd Socket or file descriptor.
+* @param buffer Buffer to be written.
+* @param size Size of the buffer.
+* @return True if the whole buffer was written.
+*/
+static bool cache_dump_write(int fd, const char *buffer, size_t size);
+
+/**
+* @brief Writes every element of the cache to a socket or a file, without holding any lock nor the epoch
+*        while writing.
+* @param cache Shared pointer to the cache to be dumped, loaded again for every chunk.
+* @param fd Socket or file descriptor.
+* @return True if every chunk was written, until the end of the cache or until it was flushed.
+*/
+bool cache_dump(lruCache_t **cache, int fd);
+
+
+
+/* Definitions */
+
+
+// Formats a chunk of the pool of a shard into a buffer, under the shard lock
+static size_t cache_dump_chunk(lruCacheShard_t *shard, size_t *position, char *buffer)
+{
+    lruCacheNode_t      *node;
+    lruCacheNodeData_t  *data;
+    uint64_t            now = lru_clock_ms();
+    size_t              size = 0;
+    size_t              end;
+
+    pthread_mutex_lock(&(shard->mutex));
+    end = *position + CACHE_DUMP_CHUNK < shard->poolUsed ? *position + CACHE_DUMP_CHUNK : shard->poolUsed;
+    for (; *position < end; (*position)++)
+    {
+        node = &(shard->cachePool[*position]);
+        data = cache_node_data(shard, node);
+        if (!node->used || (data->expiry && data->expiry <= now))
+            continue;
+
+        // The chunk ends early when the next line may not fit, and that node starts the next one
+        if (size + node->requestLength + CACHE_DUMP_LINE_SIZE > CACHE_DUMP_BUFFER_SIZE)
+            break;
+
+        memcpy(buffer + size, "Request: '", 10);
+        memcpy(buffer + size + 10, data->request, node->requestLength);
+        size += 10 + node->requestLength;
+        memcpy(buffer + size, "' with hash: '", 14);
+        md5ToHex((uint8_t *)data->md5, buffer + size + 14);
+        size += 14 + MD5_STRING_SIZE - 1;
+        memcpy(buffer + size, "'\n", 2);
+        size += 2;
+    }
+    pthread_mutex_unlock(&(shard->mutex));
+
+    return size;
+}
+
+// Writes a whole buffer to a socket or a file, retrying the partial writes
+static bool cache_dump_write(int fd, const char *buffer, size_t size)
+{
+    ssize_t written;
+
+    while (size)
+    {
+        // A client that hangs up fails the send instead of raising a SIGPIPE
+        if ((written = send(fd, buffer, size, MSG_NOSIGNAL)) < 0)
+        {
+            if (errno == ENOTSOCK)
+                return cache_snapshot_write(fd, buffer, size);
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        buffer += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+// Writes every element of the cache to a socket or a file
+bool cache_dump(lruCache_t **cache, int fd)
+{
+    lruCache_t  *current;
+    char        *buffer = malloc(CACHE_DUMP_BUFFER_SIZE);
+    uint64_t    generation;
+    size_t      shard = 0;
+    size_t      position = 1;
+    size_t      size;
+    bool        written = buffer != NULL;
+
+    epoch_enter();
+    generation = load_acquire(*cache)->generation;
+    epoch_exit();
+
+    while (written)
+    {
+        // A flushed cache may be freed as soon as it's unpinned, so only its generation is kept between chunks
+        epoch_enter();
+        current = load_acquire(*cache);
+        if (current->generation != generation)
+        {
+            epoch_exit();
+            break;
+        }
+
+        // The first node of each pool (CACHE_NIL) is never used
+        while (shard < current->shardNumber && position >= load_relaxed(current->shards[shard].poolUsed))
+        {
+            shard++;
+            position = 1;
+        }
+        if (shard == current->shardNumber)
+        {
+            epoch_exit();
+            break;
+        }
+
+        size = cache_dump_chunk(&(current->shards[shard]), &position, buffer);
+        epoch_exit();
+
+        if (size)
+            written = cache_dump_write(fd, buffer, size);
+    }
+
+    safe_free(buffer);
+    return written;
+}
@@ -0,0 +1,332 @@
+/*
+ * [meteoserver]
+ * cachePolicy.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Eviction policies of the cache, and the queues they keep their nodes in.
+ *   - Each shard has CACHE_POLICY_QUEUES circular lists of nodes, ordered from the most
+ *     recent (head) to the oldest one (tail). LRU uses one of them, ARC and S3-FIFO use two.
+ *   - 'touch' is the only callback called without the shard lock, straight from the hit path.
+ *     Policies that need to reorder their queues on a hit do it in 'hit', which is deferred
+ *     through the recency buffer.
+ *   - 'victim' only chooses the node to be evicted (it may reorder the queues on its way),
+ *     the node is unlinked by 'remove' once the eviction is confirmed.
+ */
+
+
+/**
+* @brief Inserts a node at the head of one of the queues of a shard.
+* @param shard Shard that contains the queue.
+* @param queue Queue where the node is inserted.
+* @param node Node to be inserted.
+*/
+void cache_queue_push(lruCacheShard_t *shard, uint8_t queue, lruCacheNode_t *node);
+
+/**
+* @brief Unlinks a node from the queue it belongs to.
+* @param shard Shard that contains the queue.
+* @param node Node to be unlinked.
+*/
+void cache_queue_unlink(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief Returns the oldest node of one of the queues of a shard.
+* @param shard Shard that contains the queue.
+* @param queue Queue to be checked.
+* @return Oldest node of the queue, NULL if it's empty.
+*/
+lruCacheNode_t *cache_queue_tail(lruCacheShard_t *shard, uint8_t queue);
+
+/**
+* @brief Iterates the queues of a shard, from the last queue to the first one and from the
+*        head to the tail of each one of them.
+* @param shard Shard that contains the queues.
+* @param node Current node, NULL to get the first one.
+* @return Next node, NULL when every queue has been walked.
+*/
+lruCacheNode_t *cache_queue_next(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief Returns the policy corresponding to a name.
+* @param name Name of the policy.
+* @return Policy, NULL if there's no policy with that name.
+*/
+const cachePolicy_t *cache_policy_find(char *name);
+
+/**
+* @brief Returns the number of elements a policy sizes its queues for: the nodes of the shard, or
+*        the elements it currently holds when the shard is limited by a byte budget.
+* @param shard Shard whose capacity is returned.
+* @return Capacity of the shard in elements, at least 1.
+*/
+size_t cache_policy_capacity(lruCacheShard_t *shard);
+
+/**
+* @brief LRU: moves a hit node to the head of the queue.
+* @param shard Shard that contains the node.
+* @param node Node that has been hit.
+*/
+static void lru_policy_hit(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief LRU: inserts a new node at the head of the queue.
+* @param shard Shard that contains the node.
+* @param node Node to be inserted.
+* @param hash Hash of the request of the node.
+*/
+static void lru_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+/**
+* @brief LRU: chooses the least recently used node.
+* @param shard Shard whose node will be evicted.
+* @param hash Hash of the request that will replace the victim.
+* @return Node to be evicted.
+*/
+static lruCacheNode_t *lru_policy_victim(lruCacheShard_t *shard, uint64_t hash);
+
+/**
+* @brief Unlinks an evicted node from its queue. Shared by the policies without ghosts.
+* @param shard Shard that contains the node.
+* @param node Node to be evicted.
+* @param hash Hash of the request of the node.
+*/
+static void cache_policy_remove(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+/**
+* @brief CLOCK: sets the reference bit of a hit node.
+* @param node Node that has been hit.
+*/
+static void clock_policy_touch(lruCacheNode_t *node);
+
+/**
+* @brief CLOCK: clears the reference bit of a new node.
+* @param shard Shard that contains the node.
+* @param node Node to be inserted.
+* @param hash Hash of the request of the node.
+*/
+static void clock_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+/**
+* @brief CLOCK: sweeps the hand over the used part of the contiguous pool until it finds a node without
+*        its reference bit, giving a second chance (and clearing the bit) to the referenced ones.
+*        Free nodes are skipped.
+* @param shard Shard whose node will be evicted.
+* @param hash Hash of the request that will replace the victim.
+* @return Node to be evicted.
+*/
+static lruCacheNode_t *clock_policy_victim(lruCacheShard_t *shard, uint64_t hash);
+
+/**
+* @brief CLOCK: nodes are not kept in any order, so the pool is iterated as is, skipping the free nodes.
+* @param shard Shard that contains the nodes.
+* @param node Current node, NULL to get the first one.
+* @return Next node, NULL when the whole pool has been walked.
+*/
+static lruCacheNode_t *clock_policy_next(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+
+
+/* Policies */
+
+
+const cachePolicy_t lruPolicy = {
+    .name = "lru",
+    .touch = NULL,
+    .hit = lru_policy_hit,
+    .insert = lru_policy_insert,
+    .victim = lru_policy_victim,
+    .remove = cache_policy_remove,
+    .next = cache_queue_next
+};
+
+const cachePolicy_t clockPolicy = {
+    .name = "clock",
+    .touch = clock_policy_touch,
+    .hit = NULL,
+    .insert = clock_policy_insert,
+    .victim = clock_policy_victim,
+    .remove = cache_policy_remove,
+    .next = clock_policy_next
+};
+
+static const cachePolicy_t *cachePolicies[] = {&lruPolicy, &clockPolicy, &arcPolicy, &s3FifoPolicy};
+
+
+
+/* Definitions */
+
+
+// Inserts a node at the head of one of the queues of a shard
+void cache_queue_push(lruCacheShard_t *shard, uint8_t queue, lruCacheNode_t *node)
+{
+    lruCacheNode_t  *head = shard->queues[queue];
+    uint32_t        index = cache_node_index(shard, node);
+
+    if (head)
+    {
+        node->next = cache_node_index(shard, head);
+        node->prev = head->prev;
+        cache_node(shard, head->prev)->next = index;
+        head->prev = index;
+    }
+    else
+    {
+        node->next = index;
+        node->prev = index;
+    }
+
+    node->queue = queue;
+    shard->queues[queue] = node;
+    shard->queueSizes[queue]++;
+}
+
+// Unlinks a node from the queue it belongs to
+void cache_queue_unlink(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    if (cache_node(shard, node->next) == node)
+        shard->queues[node->queue] = NULL;
+    else
+    {
+        cache_node(shard, node->prev)->next = node->next;
+        cache_node(shard, node->next)->prev = node->prev;
+        if (shard->queues[node->queue] == node)
+            shard->queues[node->queue] = cache_node(shard, node->next);
+    }
+
+    node->next = CACHE_NIL;
+    node->prev = CACHE_NIL;
+    shard->queueSizes[node->queue]--;
+}
+
+// Returns the oldest node of one of the queues of a shard
+lruCacheNode_t *cache_queue_tail(lruCacheShard_t *shard, uint8_t queue)
+{
+    return shard->queues[queue] ? cache_node(shard, shard->queues[queue]->prev) : NULL;
+}
+
+// Iterates the queues of a shard, from the last queue to the first one
+lruCacheNode_t *cache_queue_next(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    int queue = CACHE_POLICY_QUEUES - 1;
+
+    if (node)
+    {
+        if (cache_node(shard, node->next) != shard->queues[node->queue])
+            return cache_node(shard, node->next);
+        queue = node->queue - 1;
+    }
+
+    while (queue >= 0 && !shard->queues[queue])
+        queue--;
+
+    return queue >= 0 ? shard->queues[queue] : NULL;
+}
+
+// Returns the policy corresponding to a name
+const cachePolicy_t *cache_policy_find(char *name)
+{
+    for (size_t i = 0; i < sizeof(cachePolicies) / sizeof(cachePolicies[0]); i++)
+    {
+        if (!strcmp(name, cachePolicies[i]->name))
+            return cachePolicies[i];
+    }
+
+    return NULL;
+}
+
+// Returns the number of elements a policy sizes its queues for
+size_t cache_policy_capacity(lruCacheShard_t *shard)
+{
+    if (!shard->byteCapacity)
+        return shard->totalCapacity;
+
+    return shard->currentCapacity ? shard->currentCapacity : 1;
+}
+
+// LRU: moves a hit node to the head of the queue
+static void lru_policy_hit(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    if (shard->queues[0] == node)
+        return;
+
+    cache_queue_unlink(shard, node);
+    cache_queue_push(shard, 0, node);
+}
+
+// LRU: inserts a new node at the head of the queue
+static void lru_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    (void)hash;
+    cache_queue_push(shard, 0, node);
+}
+
+// LRU: chooses the least recently used node
+static lruCacheNode_t *lru_policy_victim(lruCacheShard_t *shard, uint64_t hash)
+{
+    (void)hash;
+    return cache_queue_tail(shard, 0);
+}
+
+// Unlinks an evicted node from its queue
+static void cache_policy_remove(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    (void)hash;
+    if (node->next)
+        cache_queue_unlink(shard, node);
+}
+
+// CLOCK: sets the reference bit of a hit node
+static void clock_policy_touch(lruCacheNode_t *node)
+{
+    if (!load_relaxed(node->frequency))
+        store_relaxed(node->frequency, 1);
+}
+
+// CLOCK: clears the reference bit of a new node
+static void clock_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    (void)shard;
+    (void)hash;
+    store_relaxed(node->frequency, 0);
+}
+
+// CLOCK: sweeps the hand over the contiguous pool until it finds a node without its reference bit
+static lruCacheNode_t *clock_policy_victim(lruCacheShard_t *shard, uint64_t hash)
+{
+    lruCacheNode_t *victim;
+
+    (void)hash;
+    for (;;)
+    {
+        victim = &(shard->cachePool[shard->clockHand]);
+        shard->clockHand = (shard->clockHand + 1) % shard->poolUsed;
+
+        if (!victim->used)
+            continue;
+        if (!load_relaxed(victim->frequency))
+            return victim;
+        store_relaxed(victim->frequency, 0);
+    }
+}
+
+// CLOCK: nodes are not kept in any order, so the pool is iterated as is, skipping the free nodes
+static lruCacheNode_t *clock_policy_next(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    node = node ? node + 1 : shard->cachePool;
+    while (node < shard->cachePool + shard->poolUsed && !node->used)
+        node++;
+
+    return node < shard->cachePool + shard->poolUsed ? node : NULL;
+}
@@ -0,0 +1,270 @@
+/*
+ * [meteoserver]
+ * cacheSnapshot.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Snapshots of the cache, saved to a binary file and restored on startup:
+ *   - The file starts with a snapshotHeader_t, followed by its elements back to back: a packed
+ *     snapshotEntry_t (expiration, digest and length) and the request, with its NUL byte.
+ *   - Elements are saved shard by shard, from the least to the most recently used one, so
+ *     inserting them in the order of the file rebuilds the order kept by the policy.
+ *   - Each shard is copied to a buffer under its lock and written once released, to a
+ *     temporary file that replaces the snapshot when it's complete.
+ *   - Restoring maps the file and inserts its requests straight from the mapping: short
+ *     requests are copied inside their nodes, so the load costs no allocation per element.
+ *   - Expirations are saved on the wall clock, so the time the server was down counts.
+ *   - The number of shards in the header is only informative: restored requests are hashed
+ *     again, so a snapshot can be loaded into a cache with any number of shards.
+ *   - Only the elements actually inserted are counted as restored, not the ones already cached
+ *     nor the ones over the byte budget of their shard.
+ */
+
+
+/**
+* @brief Returns the current time of the wall clock.
+* @return Milliseconds elapsed since the epoch.
+*/
+uint64_t cache_snapshot_clock_ms();
+
+/**
+* @brief Copies the elements of a shard into a buffer, in the format of the file and from the least to
+*        the most recently used one.
+* @param cache Cache that contains the shard.
+* @param shard Shard to be copied.
+* @param size Filled with the size of the buffer.
+* @param elements Filled with the number of elements copied.
+* @return Allocated buffer, NULL if the shard is empty.
+*/
+static char *cache_snapshot_shard(lruCache_t *cache, lruCacheShard_t *shard, size_t *size, size_t *elements);
+
+/**
+* @brief Writes a whole buffer to a file, retrying the partial writes.
+* @param fd File descriptor.
+* @param buffer Buffer to be written.
+* @param size Size of the buffer.
+* @return True if the whole buffer was written.
+*/
+bool cache_snapshot_write(int fd, const void *buffer, size_t size);
+
+/**
+* @brief Saves the elements of the cache to a snapshot file, replacing it once it's complete.
+* @param cache Cache to be saved.
+* @param path Path of the snapshot file.
+* @return True if the snapshot was saved.
+*/
+bool cache_snapshot_save(lruCache_t *cache, char *path);
+
+/**
+* @brief Restores the elements of a snapshot file into the cache, skipping the expired ones.
+* @param cache Cache to be filled.
+* @param path Path of the snapshot file.
+* @param restored Filled with the number of elements restored.
+* @return True if the snapshot was restored or doesn't exist, false if it isn't valid.
+*/
+bool cache_snapshot_load(lruCache_t *cache, char *path, size_t *restored);
+
+
+
+/* Definitions */
+
+
+// Returns the current time of the wall clock
+uint64_t cache_snapshot_clock_ms()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Copies the elements of a shard into a buffer, from the least to the most recently used one
+static char *cache_snapshot_shard(lruCache_t *cache, lruCacheShard_t *shard, size_t *size, size_t *elements)
+{
+    lruCacheNode_t      **nodes;
+    lruCacheNode_t      *node;
+    lruCacheNodeData_t  *data;
+    snapshotEntry_t     entry;
+    char                *buffer = NULL;
+    uint64_t            monotonic = lru_clock_ms();
+    uint64_t            wall = cache_snapshot_clock_ms();
+    size_t              count = 0;
+
+    *size = 0;
+    pthread_mutex_lock(&(shard->mutex));
+
+    // The policy walks its elements from the most recently used one, and the expired ones are left out
+    nodes = malloc(shard->currentCapacity * sizeof(lruCacheNode_t *));
+    for (node = cache->policy->next(shard, NULL); node && nodes; node = cache->policy->next(shard, node))
+    {
+        data = cache_node_data(shard, node);
+        if (data->expiry && data->expiry <= monotonic)
+            continue;
+
+        nodes[count++] = node;
+        *size += sizeof(snapshotEntry_t) + node->requestLength + 1;
+    }
+
+    if (count && (buffer = malloc(*size)))
+    {
+        *size = 0;
+        for (size_t i = count; i-- > 0;)
+        {
+            node = nodes[i];
+            data = cache_node_data(shard, node);
+            entry.expiresAt = data->expiry ? wall + (data->expiry - monotonic) : 0;
+            memcpy(entry.md5, data->md5, MD5_DIGEST_SIZE);
+            entry.length = node->requestLength;
+
+            memcpy(buffer + *size, &entry, sizeof(snapshotEntry_t));
+            memcpy(buffer + *size + sizeof(snapshotEntry_t), data->request, entry.length + 1);
+            *size += sizeof(snapshotEntry_t) + entry.length + 1;
+        }
+    }
+
+    pthread_mutex_unlock(&(shard->mutex));
+    safe_free(nodes);
+
+    *elements = buffer ? count : 0;
+    if (buffer == NULL)
+        *size = 0;
+    return buffer;
+}
+
+// Writes a whole buffer to a file, retrying the partial writes
+bool cache_snapshot_write(int fd, const void *buffer, size_t size)
+{
+    ssize_t written;
+
+    while (size)
+    {
+        if ((written = write(fd, buffer, size)) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        buffer = (const char *)buffer + written;
+        size -= written;
+    }
+
+    return true;
+}
+
+// Saves the elements of the cache to a snapshot file, replacing it once it's complete
+bool cache_snapshot_save(lruCache_t *cache, char *path)
+{
+    snapshotHeader_t    header = {0};
+    char                tmpPath[PATH_MAX];
+    char                *buffer;
+    size_t              size;
+    size_t              elements;
+    bool                saved;
+    int                 fd;
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    if ((fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+        fprintf(stderr, "Error: Can't create the snapshot '%s': '%s'.\n", tmpPath, strerror(errno));
+        return false;
+    }
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.shardNumber = cache->shardNumber;
+
+    // The header is written again at the end, with the final number of elements
+    saved = cache_snapshot_write(fd, &header, sizeof(header));
+    for (size_t i = 0; saved && i < cache->shardNumber; i++)
+    {
+        if ((buffer = cache_snapshot_shard(cache, &(cache->shards[i]), &size, &elements)) == NULL)
+            continue;
+
+        saved = cache_snapshot_write(fd, buffer, size);
+        header.elements += elements;
+        safe_free(buffer);
+    }
+
+    saved = saved && pwrite(fd, &header, sizeof(header), 0) == sizeof(header) && fdatasync(fd) == 0;
+    close(fd);
+
+    if (saved == false || rename(tmpPath, path) < 0)
+    {
+        fprintf(stderr, "Error: Can't save the snapshot '%s': '%s'.\n", path, strerror(errno));
+        unlink(tmpPath);
+        return false;
+    }
+
+    return true;
+}
+
+// Restores the elements of a snapshot file into the cache, skipping the expired ones
+bool cache_snapshot_load(lruCache_t *cache, char *path, size_t *restored)
+{
+    snapshotHeader_t    header;
+    snapshotEntry_t     entry;
+    struct stat         info;
+    char                *data;
+    size_t              offset = sizeof(snapshotHeader_t);
+    uint64_t            monotonic = lru_clock_ms();
+    uint64_t            wall = cache_snapshot_clock_ms();
+    bool                valid;
+    int                 fd;
+
+    *restored = 0;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return errno == ENOENT;
+
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(snapshotHeader_t) ||
+        (data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    // The file is read once, from the beginning to the end
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    madvise(data, info.st_size, MADV_WILLNEED);
+
+    memcpy(&header, data, sizeof(header));
+    valid = !memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) && header.version == SNAPSHOT_VERSION;
+
+    for (uint64_t i = 0; valid && i < header.elements; i++)
+    {
+        // Every element has to fit in the file, with its request terminated where it says
+        valid = offset + sizeof(snapshotEntry_t) <= (size_t)info.st_size;
+        if (valid)
+        {
+            memcpy(&entry, data + offset, sizeof(snapshotEntry_t));
+            offset += sizeof(snapshotEntry_t);
+            valid = entry.length <= MAXREQUESTSIZE && offset + entry.length < (size_t)info.st_size &&
+                    data[offset + entry.length] == '\0';
+        }
+
+        // Every insert is pinned like the ones of the server, so the requests it evicts are freed
+        if (valid && (!entry.expiresAt || entry.expiresAt > wall))
+        {
+            epoch_enter();
+            *restored += lru_cache_restore_node(cache, data + offset, lru_hash_request(data + offset), entry.md5,
+                                                entry.expiresAt ? monotonic + (entry.expiresAt - wall) : 0);
+            epoch_exit();
+        }
+        offset += entry.length + 1;
+    }
+
+    munmap(data, info.st_size);
+    return valid;
+}
@@ -0,0 +1,121 @@
+/*
+ * [meteoserver]
+ * cacheStats.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Statistics of the cache, kept per thread so counting an operation never writes to a cache
+ * line shared with other threads:
+ *   - Each thread gets its own record, padded to whole cache lines, the first time it counts an
+ *     operation. Only its thread writes to it, with relaxed stores.
+ *   - Readers add up every record with relaxed loads, so the totals are only approximate
+ *     while the counters are being updated.
+ *   - Counters span the whole life of the server: they're kept when the cache is flushed, and
+ *     when a short-lived thread gives its record back with cache_stats_unregister, the next
+ *     thread that claims it keeps adding to them.
+ */
+
+
+/* Number of records ever claimed and the per-thread records */
+static uint32_t         statsThreadNumber = 0;
+static cacheStats_t     statsThreads[CACHE_STATS_MAX_THREADS];
+
+/* Record of the calling thread, registered the first time it counts an operation */
+static __thread cacheStats_t *statsSelf = NULL;
+
+
+/**
+* @brief Returns the record of the calling thread, registering it if needed. Threads beyond
+*        CACHE_STATS_MAX_THREADS share the last record, so some of their updates may be lost.
+* @return Record of the calling thread.
+*/
+cacheStats_t *cache_stats_thread();
+
+/**
+* @brief Gives the record of the calling thread back, so another thread can claim it. Its counters are kept.
+*/
+void cache_stats_unregister();
+
+/**
+* @brief Adds up the records of every thread.
+* @param total Filled with the sum of the counters.
+*/
+void cache_stats_read(cacheStats_t *total);
+
+
+
+/* Definitions */
+
+
+// Returns the record of the calling thread, registering it if needed
+cacheStats_t *cache_stats_thread()
+{
+    uint32_t id;
+
+    if (statsSelf)
+        return statsSelf;
+
+    // Records given back by other threads are claimed first, and the last one is shared
+    for (id = 0; id < CACHE_STATS_MAX_THREADS - 1; id++)
+    {
+        if (id >= load_acquire(statsThreadNumber))
+            id = __atomic_fetch_add(&statsThreadNumber, 1, __ATOMIC_RELAXED);
+        if (id >= CACHE_STATS_MAX_THREADS - 1)
+            break;
+
+        if (load_relaxed(statsThreads[id].claimed) == false &&
+            __atomic_exchange_n(&(statsThreads[id].claimed), true, __ATOMIC_ACQUIRE) == false)
+            break;
+    }
+    if (id >= CACHE_STATS_MAX_THREADS - 1)
+        id = CACHE_STATS_MAX_THREADS - 1;
+
+    statsSelf = &(statsThreads[id]);
+    return statsSelf;
+}
+
+// Gives the record of the calling thread back, so another thread can claim it
+void cache_stats_unregister()
+{
+    if (statsSelf == NULL)
+        return;
+
+    // The shared record is never claimed
+    if (statsSelf != &(statsThreads[CACHE_STATS_MAX_THREADS - 1]))
+        store_release(statsSelf->claimed, false);
+    statsSelf = NULL;
+}
+
+// Adds up the records of every thread
+void cache_stats_read(cacheStats_t *total)
+{
+    uint32_t threads = load_relaxed(statsThreadNumber);
+
+    if (threads > CACHE_STATS_MAX_THREADS)
+        threads = CACHE_STATS_MAX_THREADS;
+
+    memset(total, 0, sizeof(cacheStats_t));
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        total->hits += load_relaxed(statsThreads[i].hits);
+        total->misses += load_relaxed(statsThreads[i].misses);
+        total->tierHits += load_relaxed(statsThreads[i].tierHits);
+        total->inserts += load_relaxed(statsThreads[i].inserts);
+        total->rejections += load_relaxed(statsThreads[i].rejections);
+        total->evictions += load_relaxed(statsThreads[i].evictions);
+        total->expirations += load_relaxed(statsThreads[i].expirations);
+        total->demotions += load_relaxed(statsThreads[i].demotions);
+        total->nearHits += load_relaxed(statsThreads[i].nearHits);
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ * [meteoserver]
+ * cacheWarm.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Warm-up of the cache from a list of keys, one per line, before the server starts listening:
+ *   - The file is mapped and split into as many ranges as threads, each one starting right
+ *     after a newline, so every line belongs to exactly one range.
+ *   - Every thread computes the digests of the keys of its range and inserts them with the
+ *     default TTL, like a miss would but without its delay nor the admission filter. Shards are
+ *     locked per insert, so the threads only contend when their keys fall in the same shard.
+ *   - Only the keys actually inserted are counted: repeated ones and the ones over the byte
+ *     budget of their shard aren't.
+ *   - Threads pin the epoch per insert, as the requests of their victims are retired, and give
+ *     their epoch and statistics records back before exiting, freeing what they retired.
+ *   - Empty lines and keys longer than MAXREQUESTSIZE are skipped, and a trailing '\r' is dropped.
+ *   - Warmed elements aren't appended to the insert log: the list can be warmed again on restart.
+ */
+
+
+/**
+* @brief Computes the digests of the keys of a range of the file and inserts them into the cache.
+* @param range Range of the file, with the cache to be warmed up.
+*/
+static void *cache_warm_range(void *range);
+
+/**
+* @brief Inserts every key of a file into the cache, spreading them over several threads.
+* @param cache Cache to be warmed up.
+* @param path Path of the file, with one key per line.
+* @param threads Number of threads.
+* @param warmed Filled with the number of keys inserted.
+* @return True if the file was read.
+*/
+bool cache_warm(lruCache_t *cache, char *path, int threads, size_t *warmed);
+
+
+
+/* Definitions */
+
+
+// Computes the digests of the keys of a range of the file and inserts them into the cache
+static void *cache_warm_range(void *arg)
+{
+    cacheWarmRange_t    *range = (cacheWarmRange_t *)arg;
+    char                request[MAXREQUESTSIZE + 1];
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    char                *line = range->begin;
+    char                *newline;
+    size_t              length;
+    uint64_t            expiry;
+
+    for (; line < range->end; line += length + 1)
+    {
+        newline = memchr(line, '\n', range->end - line);
+        length = newline ? (size_t)(newline - line) : (size_t)(range->end - line);
+
+        request[0] = '\0';
+        if (length <= MAXREQUESTSIZE)
+        {
+            memcpy(request, line, length);
+            request[length - (length && line[length - 1] == '\r')] = '\0';
+        }
+        if (request[0] == '\0')
+            continue;
+
+        md5Digest(request, md5);
+        expiry = range->cache->defaultTtl ? lru_clock_ms() + (uint64_t)range->cache->defaultTtl * 1000 : 0;
+        epoch_enter();
+        range->warmed += lru_cache_restore_node(range->cache, request, lru_hash_request(request), md5, expiry);
+        epoch_exit();
+    }
+
+    epoch_unregister();
+    cache_stats_unregister();
+    return NULL;
+}
+
+// Inserts every key of a file into the cache, spreading them over several threads
+bool cache_warm(lruCache_t *cache, char *path, int threads, size_t *warmed)
+{
+    cacheWarmRange_t    *ranges;
+    pthread_t           *workers;
+    struct stat         info;
+    char                *data;
+    char                *newline;
+    size_t              size;
+    int                 fd;
+
+    *warmed = 0;
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &info) < 0)
+    {
+        fprintf(stderr, "Error: Can't open the warm-up file '%s': '%s'.\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    if ((size = info.st_size) == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: Can't map the warm-up file '%s': '%s'.\n", path, strerror(errno));
+        return false;
+    }
+
+    // Every range is read once, from the beginning to the end
+    madvise(data, size, MADV_SEQUENTIAL);
+    madvise(data, size, MADV_WILLNEED);
+
+    ranges = calloc(threads, sizeof(cacheWarmRange_t));
+    workers = calloc(threads, sizeof(pthread_t));
+    if (ranges == NULL || workers == NULL)
+    {
+        safe_free(ranges);
+        safe_free(workers);
+        munmap(data, size);
+        return false;
+    }
+
+    // Every range starts at the first line that begins within its share of the file
+    for (int i = 0; i < threads; i++)
+    {
+        ranges[i].cache = cache;
+        ranges[i].begin = data + size * i / threads;
+        if (ranges[i].begin > data && ranges[i].begin[-1] != '\n')
+        {
+            newline = memchr(ranges[i].begin, '\n', data + size - ranges[i].begin);
+            ranges[i].begin = newline ? newline + 1 : data + size;
+        }
+        if (i > 0 && ranges[i].begin < ranges[i - 1].begin)
+            ranges[i].begin = ranges[i - 1].begin;
+        if (i > 0)
+            ranges[i - 1].end = ranges[i].begin;
+    }
+    ranges[threads - 1].end = data + size;
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&(workers[i]), NULL, cache_warm_range, &(ranges[i]));
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(workers[i], NULL);
+        *warmed += ranges[i].warmed;
+    }
+
+    free(ranges);
+    free(workers);
+    munmap(data, size);
+    return true;
+}
@@ -0,0 +1,274 @@
+/*
+ * [meteoserver]
+ * diskTier.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Second tier of the cache, kept in a memory-mapped file so it can be much bigger than the
+ * memory given to the cache itself:
+ *   - The elements evicted from the cache to make room for new ones are demoted to it, and
+ *     the misses of the cache look for their request in it before computing it again.
+ *   - The file is an open-addressing hash table: the hash of a request chooses a bucket of
+ *     DISK_TIER_BUCKET_SLOTS fixed-size slots (1 KB), that's searched linearly. Each bucket
+ *     is a small FIFO queue: demoted elements are inserted first, and the last slot is
+ *     dropped when it's full.
+ *   - Requests longer than DISK_TIER_KEY_SIZE don't fit in a slot and aren't demoted.
+ *   - Buckets are locked by stripes of DISK_TIER_STRIPES mutexes.
+ *   - Slots are only valid for the generation of the tier they were written in, so the tier
+ *     is emptied by increasing its generation. The file is emptied on startup as well: its
+ *     expirations are kept on the monotonic clock.
+ *   - Demotions are done once the lock of the shard is released, so a cache may demote its
+ *     victims after it has been flushed: the tier remembers the cache it was emptied for, and
+ *     drops the elements of older ones.
+ *   - An element promoted back to memory leaves the tier, so it isn't found there once it's
+ *     evicted from memory again with a newer value or expiration.
+ */
+
+
+/**
+* @brief Returns the lock and the first slot of the bucket of a hash.
+* @param tier Disk tier.
+* @param hash Hash of the request.
+* @param lock Filled with the lock of the bucket.
+* @return First slot of the bucket.
+*/
+static diskTierSlot_t *disk_tier_bucket(diskTier_t *tier, uint64_t hash, pthread_mutex_t **lock);
+
+/**
+* @brief Creates the disk tier file, or empties it, and maps it in memory.
+* @param path Path of the file.
+* @param bytes Size of the file, rounded down to a power of two of buckets.
+* @return Disk tier, NULL if the file can't be created or mapped.
+*/
+diskTier_t *disk_tier_open(char *path, size_t bytes);
+
+/**
+* @brief Unmaps the disk tier and frees it.
+* @param tier Disk tier to be closed.
+*/
+void disk_tier_close(diskTier_t *tier);
+
+/**
+* @brief Copies an evicted element into a slot, so it can be demoted once the lock of its shard is released.
+* @param slot Slot to be filled.
+* @param request Request of the element.
+* @param length Length of the request.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Digest of the request.
+* @param expiry Expiration of the element on the monotonic clock, 0 if it never expires.
+* @return True if the element can be demoted: its request fits in a slot and it hasn't expired.
+*/
+bool disk_tier_stage(diskTierSlot_t *slot, char *request, size_t length, uint64_t hash, uint8_t *md5, uint64_t expiry);
+
+/**
+* @brief Demotes an element to the disk tier, as the first one of its bucket.
+* @param tier Disk tier.
+* @param slot Slot filled by disk_tier_stage.
+* @param generation Generation of the cache the element was evicted from. It's dropped if the tier
+*        has been emptied for a newer cache.
+*/
+void disk_tier_put(diskTier_t *tier, diskTierSlot_t *slot, uint64_t generation);
+
+/**
+* @brief Searches for a request in the disk tier and takes it out, to be promoted back to memory.
+* @param tier Disk tier.
+* @param request Request to be searched.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Buffer where the digest is copied when found.
+* @param expiry Filled with the expiration of the element when found.
+* @return True if the request was found and hasn't expired.
+*/
+bool disk_tier_take(diskTier_t *tier, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry);
+
+/**
+* @brief Empties the disk tier by increasing its generation, without touching its slots.
+* @param tier Disk tier.
+* @param generation Generation of the cache that replaces the flushed one.
+*/
+void disk_tier_clear(diskTier_t *tier, uint64_t generation);
+
+/**
+* @brief Returns the number of slots of the disk tier.
+* @param tier Disk tier.
+* @return Number of elements the tier can hold.
+*/
+size_t disk_tier_capacity(diskTier_t *tier);
+
+
+
+/* Definitions */
+
+
+// Returns the lock and the first slot of the bucket of a hash
+static diskTierSlot_t *disk_tier_bucket(diskTier_t *tier, uint64_t hash, pthread_mutex_t **lock)
+{
+    size_t bucket = hash & tier->bucketMask;
+
+    *lock = &(tier->locks[bucket & (DISK_TIER_STRIPES - 1)]);
+    return &(tier->slots[bucket * DISK_TIER_BUCKET_SLOTS]);
+}
+
+// Creates the disk tier file, or empties it, and maps it in memory
+diskTier_t *disk_tier_open(char *path, size_t bytes)
+{
+    diskTier_t  *tier;
+    size_t      buckets = 1;
+    size_t      mapSize;
+    void        *data;
+    int         fd;
+
+    while (buckets * 2 * DISK_TIER_BUCKET_SLOTS * sizeof(diskTierSlot_t) <= bytes)
+        buckets *= 2;
+    mapSize = DISK_TIER_HEADER_SIZE + buckets * DISK_TIER_BUCKET_SLOTS * sizeof(diskTierSlot_t);
+
+    // Truncating the file first leaves it sparse: every slot reads as empty, and only takes disk once written
+    if ((fd = open(path, O_RDWR | O_CREAT, 0644)) < 0 || ftruncate(fd, 0) < 0 || ftruncate(fd, mapSize) < 0 ||
+        (data = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: Can't create the disk tier '%s': '%s'.\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+    close(fd);
+
+    // Accesses are scattered all over the file, so reading ahead would only waste memory
+    madvise(data, mapSize, MADV_RANDOM);
+
+    tier = calloc(1, sizeof(diskTier_t));
+    tier->header = (diskTierHeader_t *)data;
+    tier->slots = (diskTierSlot_t *)((char *)data + DISK_TIER_HEADER_SIZE);
+    tier->bucketMask = buckets - 1;
+    tier->mapSize = mapSize;
+    for (size_t i = 0; i < DISK_TIER_STRIPES; i++)
+        pthread_mutex_init(&(tier->locks[i]), NULL);
+
+    memcpy(tier->header->magic, DISK_TIER_MAGIC, sizeof(tier->header->magic));
+    tier->header->generation = 1;
+    tier->header->slotSize = sizeof(diskTierSlot_t);
+    tier->header->buckets = buckets;
+
+    return tier;
+}
+
+// Unmaps the disk tier and frees it
+void disk_tier_close(diskTier_t *tier)
+{
+    if (tier == NULL)
+        return;
+
+    munmap(tier->header, tier->mapSize);
+    for (size_t i = 0; i < DISK_TIER_STRIPES; i++)
+        pthread_mutex_destroy(&(tier->locks[i]));
+    free(tier);
+}
+
+// Copies an evicted element into a slot, so it can be demoted once the lock of its shard is released
+bool disk_tier_stage(diskTierSlot_t *slot, char *request, size_t length, uint64_t hash, uint8_t *md5, uint64_t expiry)
+{
+    if (length > DISK_TIER_KEY_SIZE || (expiry && expiry <= lru_clock_ms()))
+        return false;
+
+    slot->hash = hash;
+    slot->expiry = expiry;
+    memcpy(slot->md5, md5, MD5_DIGEST_SIZE);
+    slot->length = length;
+    memcpy(slot->request, request, length);
+
+    return true;
+}
+
+// Demotes an element to the disk tier, as the first one of its bucket
+void disk_tier_put(diskTier_t *tier, diskTierSlot_t *slot, uint64_t cacheGeneration)
+{
+    pthread_mutex_t *lock;
+    diskTierSlot_t  *bucket = disk_tier_bucket(tier, slot->hash, &lock);
+    uint32_t        generation;
+    size_t          last = DISK_TIER_BUCKET_SLOTS - 1;
+
+    // A tier emptied after this check is emptied after the write as well, since the slot keeps the old generation
+    pthread_mutex_lock(lock);
+    generation = load_acquire(tier->header->generation);
+    if (cacheGeneration < load_relaxed(tier->cacheGeneration))
+    {
+        pthread_mutex_unlock(lock);
+        return;
+    }
+
+    // An older copy of the request is replaced, otherwise the first stale slot or the oldest one
+    for (size_t i = 0; i < DISK_TIER_BUCKET_SLOTS; i++)
+    {
+        if (bucket[i].generation != generation || (bucket[i].hash == slot->hash &&
+            bucket[i].length == slot->length && !memcmp(bucket[i].request, slot->request, slot->length)))
+        {
+            last = i;
+            break;
+        }
+    }
+
+    memmove(&(bucket[1]), &(bucket[0]), last * sizeof(diskTierSlot_t));
+    memcpy(&(bucket[0]), slot, offsetof(diskTierSlot_t, request) + slot->length);
+    bucket[0].generation = generation;
+    pthread_mutex_unlock(lock);
+}
+
+// Searches for a request in the disk tier and takes it out, to be promoted back to memory
+bool disk_tier_take(diskTier_t *tier, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry)
+{
+    pthread_mutex_t *lock;
+    size_t          length = strlen(request);
+    diskTierSlot_t  *bucket = disk_tier_bucket(tier, hash, &lock);
+    uint32_t        generation;
+    bool            found = false;
+
+    if (length > DISK_TIER_KEY_SIZE)
+        return false;
+
+    pthread_mutex_lock(lock);
+    generation = load_relaxed(tier->header->generation);
+    for (size_t i = 0; i < DISK_TIER_BUCKET_SLOTS && bucket[i].generation == generation; i++)
+    {
+        if (bucket[i].hash != hash || bucket[i].length != length || memcmp(bucket[i].request, request, length))
+            continue;
+
+        found = !bucket[i].expiry || bucket[i].expiry > lru_clock_ms();
+        if (found)
+        {
+            memcpy(md5, bucket[i].md5, MD5_DIGEST_SIZE);
+            *expiry = bucket[i].expiry;
+        }
+
+        // The slot is taken out whether it expired or not, and the ones after it move up to keep the bucket in order
+        memmove(&(bucket[i]), &(bucket[i + 1]), (DISK_TIER_BUCKET_SLOTS - 1 - i) * sizeof(diskTierSlot_t));
+        bucket[DISK_TIER_BUCKET_SLOTS - 1].generation = 0;
+        break;
+    }
+    pthread_mutex_unlock(lock);
+
+    return found;
+}
+
+// Empties the disk tier by increasing its generation
+void disk_tier_clear(diskTier_t *tier, uint64_t generation)
+{
+    // A demotion that sees the new generation of the tier sees the new cache as well
+    store_relaxed(tier->cacheGeneration, generation);
+    __atomic_add_fetch(&(tier->header->generation), 1, __ATOMIC_RELEASE);
+}
+
+// Returns the number of slots of the disk tier
+size_t disk_tier_capacity(diskTier_t *tier)
+{
+    return (tier->bucketMask + 1) * DISK_TIER_BUCKET_SLOTS;
+}
@@ -0,0 +1,206 @@
+/*
+ * [meteoserver]
+ * ghostQueue.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Bounded queue of hashes of evicted requests, with a hash index to check for membership.
+ * Entries live in a single array: the last one is the sentinel of the circular list (its
+ * 'next' is the newest entry and its 'prev' the oldest one), and the unused ones are
+ * chained in a free list through 'next'.
+ */
+
+#define GHOST_NONE UINT32_MAX
+
+
+/**
+* @brief Searches for the entry of a hash.
+* @param ghost Ghost queue.
+* @param hash Hash to be searched.
+* @param link If not NULL, filled with the link that points to the entry in its bucket.
+* @return Index of the entry, GHOST_NONE if the hash is not present.
+*/
+static uint32_t ghost_queue_find(ghostQueue_t *ghost, uint64_t hash, uint32_t **link);
+
+/**
+* @brief Unlinks an entry from the queue and its bucket, and returns it to the free list.
+* @param ghost Ghost queue.
+* @param entry Index of the entry.
+* @param link Link that points to the entry in its bucket.
+*/
+static void ghost_queue_release(ghostQueue_t *ghost, uint32_t entry, uint32_t *link);
+
+/**
+* @brief Allocs and initializes a ghost queue.
+* @param capacity Maximum number of hashes kept in the queue.
+* @return Initialized ghost queue.
+*/
+ghostQueue_t *ghost_queue_init(size_t capacity);
+
+/**
+* @brief Frees a ghost queue.
+* @param ghost Ghost queue to be freed.
+*/
+void ghost_queue_free(ghostQueue_t *ghost);
+
+/**
+* @brief Inserts a hash as the newest entry of the queue, dropping the oldest one when it's full.
+* @param ghost Ghost queue.
+* @param hash Hash to be inserted.
+*/
+void ghost_queue_push(ghostQueue_t *ghost, uint64_t hash);
+
+/**
+* @brief Removes a hash from the queue.
+* @param ghost Ghost queue.
+* @param hash Hash to be removed.
+* @return True if the hash was present.
+*/
+bool ghost_queue_remove(ghostQueue_t *ghost, uint64_t hash);
+
+/**
+* @brief Checks if a hash is present in the queue.
+* @param ghost Ghost queue.
+* @param hash Hash to be searched.
+* @return True if the hash is present.
+*/
+bool ghost_queue_contains(ghostQueue_t *ghost, uint64_t hash);
+
+/**
+* @brief Removes the oldest entry of the queue.
+* @param ghost Ghost queue.
+*/
+void ghost_queue_pop(ghostQueue_t *ghost);
+
+
+
+/* Definitions */
+
+
+// Searches for the entry of a hash
+static uint32_t ghost_queue_find(ghostQueue_t *ghost, uint64_t hash, uint32_t **link)
+{
+    uint32_t *current = &(ghost->buckets[hash & ghost->bucketMask]);
+
+    while (*current != GHOST_NONE && ghost->entries[*current].hash != hash)
+        current = &(ghost->entries[*current].hashNext);
+
+    if (link)
+        *link = current;
+    return *current;
+}
+
+// Unlinks an entry from the queue and its bucket, and returns it to the free list
+static void ghost_queue_release(ghostQueue_t *ghost, uint32_t entry, uint32_t *link)
+{
+    ghostEntry_t *entries = ghost->entries;
+
+    *link = entries[entry].hashNext;
+    entries[entries[entry].prev].next = entries[entry].next;
+    entries[entries[entry].next].prev = entries[entry].prev;
+
+    entries[entry].next = ghost->freeList;
+    ghost->freeList = entry;
+    ghost->size--;
+}
+
+// Allocs and initializes a ghost queue
+ghostQueue_t *ghost_queue_init(size_t capacity)
+{
+    ghostQueue_t *ghost = calloc(1, sizeof(ghostQueue_t));
+
+    ghost->capacity = capacity;
+    ghost->entries = calloc(capacity + 1, sizeof(ghostEntry_t));
+
+    ghost->bucketMask = 1;
+    while (ghost->bucketMask < capacity)
+        ghost->bucketMask <<= 1;
+    ghost->buckets = malloc(ghost->bucketMask * sizeof(uint32_t));
+    memset(ghost->buckets, 0xff, ghost->bucketMask * sizeof(uint32_t));
+    ghost->bucketMask--;
+
+    // Empty circular list around the sentinel, every other entry is free
+    ghost->entries[capacity].next = capacity;
+    ghost->entries[capacity].prev = capacity;
+    ghost->freeList = capacity ? 0 : GHOST_NONE;
+    for (size_t i = 0; i < capacity; i++)
+        ghost->entries[i].next = i + 1 < capacity ? i + 1 : GHOST_NONE;
+
+    return ghost;
+}
+
+// Frees a ghost queue
+void ghost_queue_free(ghostQueue_t *ghost)
+{
+    if (ghost)
+    {
+        safe_free(ghost->entries);
+        safe_free(ghost->buckets);
+        safe_free(ghost);
+    }
+}
+
+// Inserts a hash as the newest entry of the queue, dropping the oldest one when it's full
+void ghost_queue_push(ghostQueue_t *ghost, uint64_t hash)
+{
+    ghostEntry_t    *entries = ghost->entries;
+    uint32_t        sentinel = ghost->capacity;
+    uint32_t        entry;
+
+    if (!ghost->capacity)
+        return;
+
+    ghost_queue_remove(ghost, hash);
+    if (ghost->size == ghost->capacity)
+        ghost_queue_pop(ghost);
+
+    entry = ghost->freeList;
+    ghost->freeList = entries[entry].next;
+
+    entries[entry].hash = hash;
+    entries[entry].next = entries[sentinel].next;
+    entries[entry].prev = sentinel;
+    entries[entries[sentinel].next].prev = entry;
+    entries[sentinel].next = entry;
+
+    entries[entry].hashNext = ghost->buckets[hash & ghost->bucketMask];
+    ghost->buckets[hash & ghost->bucketMask] = entry;
+    ghost->size++;
+}
+
+// Removes a hash from the queue
+bool ghost_queue_remove(ghostQueue_t *ghost, uint64_t hash)
+{
+    uint32_t *link;
+    uint32_t entry = ghost_queue_find(ghost, hash, &link);
+
+    if (entry == GHOST_NONE)
+        return false;
+
+    ghost_queue_release(ghost, entry, link);
+    return true;
+}
+
+// Checks if a hash is present in the queue
+bool ghost_queue_contains(ghostQueue_t *ghost, uint64_t hash)
+{
+    return ghost_queue_find(ghost, hash, NULL) != GHOST_NONE;
+}
+
+// Removes the oldest entry of the queue
+void ghost_queue_pop(ghostQueue_t *ghost)
+{
+    if (ghost->size)
+        ghost_queue_remove(ghost, ghost->entries[ghost->entries[ghost->capacity].prev].hash);
+}
@@ -0,0 +1,305 @@
+/*
+ * [meteoserver]
+ * heavyHitters.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Tracker of the most requested keys (heavy hitters), with the Space-Saving algorithm:
+ *   - A summary monitors a fixed number of requests with their counts. A request that isn't
+ *     monitored replaces the one with the lowest count, inheriting that count as its possible
+ *     overestimation (error), so every request more frequent than that is always monitored.
+ *   - Each thread of the pool counts its requests in a summary of its own, without locks, and
+ *     merges it into the global summary every HEAVY_HITTERS_MERGE_COUNT requests or every
+ *     HEAVY_HITTERS_MERGE_MS, so the global summary is only written once per batch.
+ *   - The counts of the global summary are halved every HEAVY_HITTERS_DECAY_MS, so it follows
+ *     the current traffic instead of the whole life of the server.
+ *   - Every entry keeps the buffer of its request when it's replaced, only growing it for a
+ *     longer one, so counting and merging requests doesn't allocate once the buffers are warm.
+ */
+
+
+/**
+* @brief Searches for a request in a summary, or picks the entry it has to replace.
+* @param entries Entries of the summary.
+* @param used Number of entries in use.
+* @param size Capacity of the summary.
+* @param request Request to be searched.
+* @param hash Hash of the request.
+* @param found Filled with whether the request is monitored.
+* @return Entry of the request, a free entry or the one with the lowest count.
+*/
+static heavyHitter_t *heavy_hitters_find(heavyHitter_t *entries, size_t used, size_t size, char *request,
+                                         uint64_t hash, bool *found);
+
+/**
+* @brief Copies a request into the buffer of an entry, growing it if the request doesn't fit.
+* @param entry Entry of a summary.
+* @param request Request to be copied.
+*/
+static void heavy_hitters_set_request(heavyHitter_t *entry, char *request);
+
+/**
+* @brief Merges the summary of a thread into the global one, and empties it.
+* @param local Summary of the thread.
+*/
+static void heavy_hitters_merge(heavyHittersLocal_t *local);
+
+/**
+* @brief Merges the summary of a thread that's exiting and frees it.
+* @param local Summary of the thread.
+*/
+static void heavy_hitters_local_free(void *local);
+
+/**
+* @brief Compares two heavy hitters by their counts, in descending order.
+* @param a First heavy hitter.
+* @param b Second heavy hitter.
+* @return Order of the heavy hitters, as expected by qsort.
+*/
+static int heavy_hitters_compare(const void *a, const void *b);
+
+/**
+* @brief Allocs and initializes an empty tracker.
+* @return Tracker of the heavy hitters.
+*/
+heavyHitters_t *heavy_hitters_init();
+
+/**
+* @brief Frees the global summary of the tracker. The threads that counted requests must have exited.
+* @param table Tracker to be freed.
+*/
+void heavy_hitters_free(heavyHitters_t *table);
+
+/**
+* @brief Counts a request in the summary of the calling thread, merging it into the global one when it's due.
+* @param table Tracker of the heavy hitters.
+* @param request Request to be counted.
+* @param hash Hash of the request, as computed by lru_hash_request.
+*/
+void heavy_hitters_record(heavyHitters_t *table, char *request, uint64_t hash);
+
+/**
+* @brief Copies the most requested keys of the global summary, from the most to the least requested one.
+* @param table Tracker of the heavy hitters.
+* @param top Array where the heavy hitters are copied. Their requests have to be freed by the caller.
+* @param k Maximum number of heavy hitters to be copied.
+* @return Number of heavy hitters copied.
+*/
+size_t heavy_hitters_top(heavyHitters_t *table, heavyHitter_t *top, size_t k);
+
+
+
+/* Definitions */
+
+
+// Searches for a request in a summary, or picks the entry it has to replace
+static heavyHitter_t *heavy_hitters_find(heavyHitter_t *entries, size_t used, size_t size, char *request,
+                                         uint64_t hash, bool *found)
+{
+    heavyHitter_t *minimum = &(entries[0]);
+
+    *found = false;
+    for (size_t i = 0; i < used; i++)
+    {
+        if (entries[i].hash == hash && !strcmp(entries[i].request, request))
+        {
+            *found = true;
+            return &(entries[i]);
+        }
+        if (entries[i].count < minimum->count)
+            minimum = &(entries[i]);
+    }
+
+    return used < size ? &(entries[used]) : minimum;
+}
+
+// Copies a request into the buffer of an entry, growing it if the request doesn't fit
+static void heavy_hitters_set_request(heavyHitter_t *entry, char *request)
+{
+    size_t size = strlen(request) + 1;
+
+    // Short requests share the smallest size, so most entries are allocated once
+    if (size > entry->capacity)
+    {
+        entry->capacity = size > HEAVY_HITTERS_KEY_SIZE ? size : HEAVY_HITTERS_KEY_SIZE;
+        entry->request = realloc(entry->request, entry->capacity);
+    }
+    memcpy(entry->request, request, size);
+}
+
+// Merges the summary of a thread into the global one, and empties it
+static void heavy_hitters_merge(heavyHittersLocal_t *local)
+{
+    heavyHitters_t  *table = local->table;
+    heavyHitter_t   *entry;
+    uint64_t        now = lru_clock_ms();
+    bool            found;
+
+    pthread_mutex_lock(&(table->mutex));
+    if (now - table->lastDecay >= HEAVY_HITTERS_DECAY_MS)
+    {
+        for (size_t i = 0; i < table->used; i++)
+        {
+            table->entries[i].count /= 2;
+            table->entries[i].error /= 2;
+        }
+        table->lastDecay = now;
+    }
+
+    // The requests of the thread are merged like single requests weighted by their counts,
+    // and the global entries they replace hand over their count as the error
+    for (size_t i = 0; i < local->used; i++)
+    {
+        entry = heavy_hitters_find(table->entries, table->used, HEAVY_HITTERS_SIZE, local->entries[i].request,
+                                   local->entries[i].hash, &found);
+        if (found)
+        {
+            entry->count += local->entries[i].count;
+            entry->error += local->entries[i].error;
+            continue;
+        }
+
+        if (table->used < HEAVY_HITTERS_SIZE)
+        {
+            table->used++;
+            entry->count = 0;
+            entry->error = 0;
+        }
+        entry->hash = local->entries[i].hash;
+        entry->error = entry->count + local->entries[i].error;
+        entry->count += local->entries[i].count;
+        heavy_hitters_set_request(entry, local->entries[i].request);
+    }
+    pthread_mutex_unlock(&(table->mutex));
+
+    local->used = 0;
+    local->pending = 0;
+    local->lastMerge = now;
+}
+
+// Merges the summary of a thread that's exiting and frees it
+static void heavy_hitters_local_free(void *arg)
+{
+    heavyHittersLocal_t *local = (heavyHittersLocal_t *)arg;
+
+    heavy_hitters_merge(local);
+    for (size_t i = 0; i < HEAVY_HITTERS_LOCAL_SIZE; i++)
+        safe_free(local->entries[i].request);
+    free(local);
+}
+
+// Compares two heavy hitters by their counts, in descending order
+static int heavy_hitters_compare(const void *a, const void *b)
+{
+    uint64_t countA = ((heavyHitter_t *)a)->count;
+    uint64_t countB = ((heavyHitter_t *)b)->count;
+
+    return (countA < countB) - (countA > countB);
+}
+
+// Allocs and initializes an empty tracker
+heavyHitters_t *heavy_hitters_init()
+{
+    heavyHitters_t *table = calloc(1, sizeof(heavyHitters_t));
+
+    if (table == NULL)
+        return NULL;
+
+    table->lastDecay = lru_clock_ms();
+    pthread_mutex_init(&(table->mutex), NULL);
+    pthread_key_create(&(table->local), heavy_hitters_local_free);
+
+    return table;
+}
+
+// Frees the global summary of the tracker
+void heavy_hitters_free(heavyHitters_t *table)
+{
+    heavyHittersLocal_t *local;
+
+    if (table == NULL)
+        return;
+
+    // Only the calling thread may still have a summary of its own
+    if ((local = pthread_getspecific(table->local)))
+    {
+        pthread_setspecific(table->local, NULL);
+        heavy_hitters_local_free(local);
+    }
+    pthread_key_delete(table->local);
+
+    for (size_t i = 0; i < table->used; i++)
+        safe_free(table->entries[i].request);
+    pthread_mutex_destroy(&(table->mutex));
+    free(table);
+}
+
+// Counts a request in the summary of the calling thread, merging it into the global one when it's due
+void heavy_hitters_record(heavyHitters_t *table, char *request, uint64_t hash)
+{
+    heavyHittersLocal_t *local = pthread_getspecific(table->local);
+    heavyHitter_t       *entry;
+    uint64_t            now = lru_clock_ms();
+    bool                found;
+
+    if (local == NULL)
+    {
+        local = calloc(1, sizeof(heavyHittersLocal_t));
+        local->table = table;
+        pthread_setspecific(table->local, local);
+    }
+
+    entry = heavy_hitters_find(local->entries, local->used, HEAVY_HITTERS_LOCAL_SIZE, request, hash, &found);
+    if (found)
+        entry->count++;
+    else
+    {
+        if (local->used < HEAVY_HITTERS_LOCAL_SIZE)
+        {
+            local->used++;
+            entry->count = 0;
+        }
+        entry->hash = hash;
+        entry->error = entry->count;
+        entry->count++;
+        heavy_hitters_set_request(entry, request);
+    }
+
+    if (++local->pending >= HEAVY_HITTERS_MERGE_COUNT || now - local->lastMerge >= HEAVY_HITTERS_MERGE_MS)
+        heavy_hitters_merge(local);
+}
+
+// Copies the most requested keys of the global summary, from the most to the least requested one
+size_t heavy_hitters_top(heavyHitters_t *table, heavyHitter_t *top, size_t k)
+{
+    heavyHitter_t   *sorted = malloc(HEAVY_HITTERS_SIZE * sizeof(heavyHitter_t));
+    size_t          used;
+
+    pthread_mutex_lock(&(table->mutex));
+    used = table->used;
+    memcpy(sorted, table->entries, used * sizeof(heavyHitter_t));
+    qsort(sorted, used, sizeof(heavyHitter_t), heavy_hitters_compare);
+
+    if (k > used)
+        k = used;
+    for (size_t i = 0; i < k; i++)
+    {
+        top[i] = sorted[i];
+        top[i].request = strdup(sorted[i].request);
+    }
+    pthread_mutex_unlock(&(table->mutex));
+
+    free(sorted);
+    return k;
+}
@@ -0,0 +1,163 @@
+/*
+ * [meteoserver]
+ * inflightTable.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Table of the cache misses being computed, so concurrent misses of the same request are
+ * computed only once:
+ *   - The first thread that misses a request (the leader) registers it in the table, and the
+ *     ones that miss it afterwards (the followers) sleep on its entry until it's published.
+ *   - The table is split in stripes chosen by the hash of the request, each one with its own
+ *     lock, so misses of different requests rarely wait on each other.
+ *   - The entry is unlinked when it's published and freed by the last thread that leaves it.
+ */
+
+
+/**
+* @brief Allocs and initializes an in-flight table.
+* @return Initialized in-flight table.
+*/
+inflightTable_t *inflight_table_init();
+
+/**
+* @brief Frees an in-flight table. No request can be in flight.
+* @param table In-flight table to be freed.
+*/
+void inflight_table_free(inflightTable_t *table);
+
+/**
+* @brief Registers a cache miss. The first thread that misses a request becomes its leader,
+*        and the rest wait until the leader publishes its digest.
+* @param table In-flight table.
+* @param request Request that has been missed. Must be kept until the entry is published.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Buffer where the digest published by the leader is copied.
+* @return Entry of the request when the caller is the leader, NULL once the digest has been copied.
+*/
+inflightEntry_t *inflight_table_acquire(inflightTable_t *table, char *request, uint64_t hash, uint8_t *md5);
+
+/**
+* @brief Publishes the digest of a request, waking up its followers and unregistering it.
+* @param table In-flight table.
+* @param entry Entry returned to the leader by inflight_table_acquire.
+* @param md5 Digest of the request.
+*/
+void inflight_table_publish(inflightTable_t *table, inflightEntry_t *entry, uint8_t *md5);
+
+
+
+/* Definitions */
+
+
+// Allocs and initializes an in-flight table
+inflightTable_t *inflight_table_init()
+{
+    inflightTable_t *table = aligned_alloc(CACHE_LINE_SIZE, sizeof(inflightTable_t));
+
+    if (table == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < INFLIGHT_TABLE_STRIPES; i++)
+    {
+        table->stripes[i].entries = NULL;
+        pthread_mutex_init(&(table->stripes[i].mutex), NULL);
+    }
+
+    return table;
+}
+
+// Frees an in-flight table
+void inflight_table_free(inflightTable_t *table)
+{
+    if (table == NULL)
+        return;
+
+    for (size_t i = 0; i < INFLIGHT_TABLE_STRIPES; i++)
+        pthread_mutex_destroy(&(table->stripes[i].mutex));
+    free(table);
+}
+
+// Registers a cache miss, returning its entry only to the leader
+inflightEntry_t *inflight_table_acquire(inflightTable_t *table, char *request, uint64_t hash, uint8_t *md5)
+{
+    inflightStripe_t    *stripe = &(table->stripes[hash & (INFLIGHT_TABLE_STRIPES - 1)]);
+    inflightEntry_t     *entry;
+
+    pthread_mutex_lock(&(stripe->mutex));
+
+    entry = stripe->entries;
+    while (entry && (entry->hash != hash || strcmp(request, entry->request)))
+        entry = entry->next;
+
+    // First miss of the request: the caller computes it
+    if (entry == NULL)
+    {
+        entry = malloc(sizeof(inflightEntry_t));
+        entry->request = request;
+        entry->hash = hash;
+        entry->done = false;
+        entry->waiters = 0;
+        pthread_cond_init(&(entry->published), NULL);
+        entry->next = stripe->entries;
+        stripe->entries = entry;
+
+        pthread_mutex_unlock(&(stripe->mutex));
+        return entry;
+    }
+
+    // Otherwise wait for the leader, the last follower to leave frees the entry
+    entry->waiters++;
+    while (entry->done == false)
+        pthread_cond_wait(&(entry->published), &(stripe->mutex));
+
+    memcpy(md5, entry->md5, MD5_DIGEST_SIZE);
+    if (--entry->waiters == 0)
+    {
+        pthread_cond_destroy(&(entry->published));
+        free(entry);
+    }
+
+    pthread_mutex_unlock(&(stripe->mutex));
+    return NULL;
+}
+
+// Publishes the digest of a request, waking up its followers and unregistering it
+void inflight_table_publish(inflightTable_t *table, inflightEntry_t *entry, uint8_t *md5)
+{
+    inflightStripe_t    *stripe = &(table->stripes[entry->hash & (INFLIGHT_TABLE_STRIPES - 1)]);
+    inflightEntry_t     **link;
+
+    pthread_mutex_lock(&(stripe->mutex));
+
+    link = &(stripe->entries);
+    while (*link != entry)
+        link = &((*link)->next);
+    *link = entry->next;
+
+    // The request belongs to the leader, so it can't be compared once it has been published
+    entry->request = NULL;
+    memcpy(entry->md5, md5, MD5_DIGEST_SIZE);
+    entry->done = true;
+
+    if (entry->waiters)
+        pthread_cond_broadcast(&(entry->published));
+    else
+    {
+        pthread_cond_destroy(&(entry->published));
+        free(entry);
+    }
+
+    pthread_mutex_unlock(&(stripe->mutex));
+}
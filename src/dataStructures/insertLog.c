@@ -0,0 +1,352 @@
+/*
+ * [meteoserver]
+ * insertLog.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Append-only log of the elements inserted in the cache, replayed on top of the last snapshot
+ * to rebuild the cache after a crash:
+ *   - Records are the elements of a snapshot (snapshotEntry_t, request and NUL byte), preceded
+ *     by a checksum so a torn or zeroed tail left by a crash is detected and cut off.
+ *   - Threads of the pool only copy their records to a buffer in memory. A writer thread swaps
+ *     it with a spare one every INSERT_LOG_FLUSH_MS and writes it with a single write (group
+ *     commit), syncing the file every INSERT_LOG_SYNC_MS. Threads never wait for the disk: a
+ *     thread that finds the buffer full wakes the writer and drops its record, which only costs
+ *     a recomputation of the element after a crash.
+ *   - The log is compacted by saving a snapshot while the writer is paused and truncating
+ *     the log once it's saved. Records appended meanwhile wait in the buffer, and the ones
+ *     buffered before the pause are dropped with the log, as their elements are in the snapshot.
+ *   - Records carry the generation of the cache they were inserted in. Once a cache has been
+ *     saved, the records of older ones belong to a flushed cache and are dropped.
+ */
+
+
+/**
+* @brief Computes the checksum of a record (64-bit FNV-1a of its element and its request).
+* @param entry Element of the record.
+* @param request Request of the record.
+* @return Checksum of the record.
+*/
+static uint64_t insert_log_checksum(snapshotEntry_t *entry, char *request);
+
+/**
+* @brief Replays the valid records of a log file into the cache.
+* @param cache Cache to be filled.
+* @param fd File descriptor of the log, open for reading.
+* @param replayed Filled with the number of records replayed.
+* @return Size of the valid part of the log, where the next record has to be appended.
+*/
+static size_t insert_log_replay(lruCache_t *cache, int fd, size_t *replayed);
+
+/**
+* @brief Writes the buffered records to the log file in batches, and syncs it periodically.
+* @param log Insert log.
+*/
+static void *insert_log_writer(void *log);
+
+/**
+* @brief Opens an insert log, replaying its records into the cache first, and starts its writer thread.
+* @param path Path of the log file.
+* @param cache Cache where the records are replayed.
+* @param replayed Filled with the number of records replayed.
+* @return Insert log, NULL if the file can't be opened.
+*/
+insertLog_t *insert_log_open(char *path, lruCache_t *cache, size_t *replayed);
+
+/**
+* @brief Writes the pending records, stops the writer thread and closes the log.
+* @param log Insert log to be closed.
+*/
+void insert_log_close(insertLog_t *log);
+
+/**
+* @brief Appends the record of an inserted element to the buffer. It never waits for the disk: the record is
+*        dropped if the buffer is full.
+* @param log Insert log.
+* @param request Inserted request.
+* @param md5 Digest of the request.
+* @param ttl Seconds until the element expires, 0 if it never does.
+* @param generation Generation of the cache the element was inserted in.
+*/
+void insert_log_append(insertLog_t *log, char *request, uint8_t *md5, unsigned int ttl, uint64_t generation);
+
+/**
+* @brief Returns the size of the log file.
+* @param log Insert log.
+* @return Size of the log file in bytes.
+*/
+size_t insert_log_size(insertLog_t *log);
+
+/**
+* @brief Pauses the writer, waiting for the write in progress, before compacting the log. The records
+*        written or buffered so far belong to elements already in the cache, or to older caches.
+* @param log Insert log.
+* @param generation Generation of the cache about to be saved. Records of older caches are dropped from now on.
+*/
+void insert_log_pause(insertLog_t *log, uint64_t generation);
+
+/**
+* @brief Resumes the writer after a compaction, truncating the log when the snapshot was saved.
+* @param log Insert log.
+* @param truncate Whether the records written or buffered before the pause are already in a snapshot.
+*/
+void insert_log_resume(insertLog_t *log, bool truncate);
+
+
+
+/* Definitions */
+
+
+// Computes the checksum of a record
+static uint64_t insert_log_checksum(snapshotEntry_t *entry, char *request)
+{
+    uint64_t        hash = 0xcbf29ce484222325ULL;
+    unsigned char   *bytes = (unsigned char *)entry;
+
+    for (size_t i = 0; i < sizeof(snapshotEntry_t); i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    for (size_t i = 0; i < entry->length; i++)
+        hash = (hash ^ (unsigned char)request[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+// Replays the valid records of a log file into the cache
+static size_t insert_log_replay(lruCache_t *cache, int fd, size_t *replayed)
+{
+    insertLogRecord_t   record;
+    struct stat         info;
+    char                *data;
+    char                *request;
+    size_t              offset = 0;
+    uint64_t            monotonic = lru_clock_ms();
+    uint64_t            wall = cache_snapshot_clock_ms();
+
+    *replayed = 0;
+    if (fstat(fd, &info) < 0 || info.st_size == 0 ||
+        (data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+        return 0;
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    // Records are replayed up to the first one that's incomplete or damaged
+    while (offset + sizeof(insertLogRecord_t) <= (size_t)info.st_size)
+    {
+        memcpy(&record, data + offset, sizeof(insertLogRecord_t));
+        request = data + offset + sizeof(insertLogRecord_t);
+
+        if (record.entry.length > MAXREQUESTSIZE ||
+            offset + sizeof(insertLogRecord_t) + record.entry.length >= (size_t)info.st_size ||
+            request[record.entry.length] != '\0' || insert_log_checksum(&record.entry, request) != record.checksum)
+            break;
+
+        // Every insert is pinned like the ones of the server, so the requests it evicts are freed
+        if (!record.entry.expiresAt || record.entry.expiresAt > wall)
+        {
+            epoch_enter();
+            lru_cache_restore_node(cache, request, lru_hash_request(request), record.entry.md5,
+                                   record.entry.expiresAt ? monotonic + (record.entry.expiresAt - wall) : 0);
+            epoch_exit();
+            (*replayed)++;
+        }
+        offset += sizeof(insertLogRecord_t) + record.entry.length + 1;
+    }
+
+    munmap(data, info.st_size);
+    return offset;
+}
+
+// Writes the buffered records to the log file in batches, and syncs it periodically
+static void *insert_log_writer(void *arg)
+{
+    insertLog_t     *log = (insertLog_t *)arg;
+    struct timespec deadline;
+    uint64_t        lastSync = lru_clock_ms();
+    char            *buffer;
+    size_t          size;
+
+    pthread_mutex_lock(&(log->mutex));
+    while (log->stopped == false || (log->used && log->paused == false))
+    {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += INSERT_LOG_FLUSH_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        if (log->stopped == false)
+            pthread_cond_timedwait(&(log->wake), &(log->mutex), &deadline);
+
+        if (log->paused || log->used == 0)
+            continue;
+
+        // The records gathered since the last batch are written in one go, while the pool fills the spare buffer
+        buffer = log->buffer;
+        size = log->used;
+        log->buffer = log->spare;
+        log->spare = buffer;
+        log->used = 0;
+        log->writing = true;
+        pthread_mutex_unlock(&(log->mutex));
+
+        if (cache_snapshot_write(log->fd, buffer, size) == false)
+            fprintf(stderr, "Error: Can't write to the insert log: '%s'.\n", strerror(errno));
+        if (lru_clock_ms() - lastSync >= INSERT_LOG_SYNC_MS)
+        {
+            fdatasync(log->fd);
+            lastSync = lru_clock_ms();
+        }
+
+        pthread_mutex_lock(&(log->mutex));
+        log->size += size;
+        log->writing = false;
+        pthread_cond_broadcast(&(log->written));
+    }
+    pthread_mutex_unlock(&(log->mutex));
+
+    fdatasync(log->fd);
+    pthread_exit(NULL);
+}
+
+// Opens an insert log, replaying its records into the cache first, and starts its writer thread
+insertLog_t *insert_log_open(char *path, lruCache_t *cache, size_t *replayed)
+{
+    insertLog_t *log;
+    int         fd;
+
+    if ((fd = open(path, O_RDWR | O_CREAT, 0644)) < 0)
+    {
+        fprintf(stderr, "Error: Can't open the insert log '%s': '%s'.\n", path, strerror(errno));
+        return NULL;
+    }
+
+    log = calloc(1, sizeof(insertLog_t));
+    log->fd = fd;
+    log->buffer = malloc(INSERT_LOG_BUFFER_SIZE);
+    log->spare = malloc(INSERT_LOG_BUFFER_SIZE);
+
+    // A damaged tail is cut off, so the new records follow the last valid one
+    log->size = insert_log_replay(cache, fd, replayed);
+    if (ftruncate(fd, log->size) < 0 || lseek(fd, log->size, SEEK_SET) < 0)
+        fprintf(stderr, "Error: Can't truncate the insert log '%s': '%s'.\n", path, strerror(errno));
+
+    pthread_mutex_init(&(log->mutex), NULL);
+    pthread_cond_init(&(log->wake), NULL);
+    pthread_cond_init(&(log->written), NULL);
+    pthread_create(&(log->writer), NULL, insert_log_writer, log);
+
+    return log;
+}
+
+// Writes the pending records, stops the writer thread and closes the log
+void insert_log_close(insertLog_t *log)
+{
+    if (log == NULL)
+        return;
+
+    pthread_mutex_lock(&(log->mutex));
+    log->stopped = true;
+    log->paused = false;
+    pthread_cond_signal(&(log->wake));
+    pthread_mutex_unlock(&(log->mutex));
+    pthread_join(log->writer, NULL);
+
+    if (log->dropped)
+        fprintf(stderr, "Warning: %zu records were dropped from the full buffer of the insert log.\n", log->dropped);
+
+    close(log->fd);
+    pthread_mutex_destroy(&(log->mutex));
+    pthread_cond_destroy(&(log->wake));
+    pthread_cond_destroy(&(log->written));
+    safe_free(log->buffer);
+    safe_free(log->spare);
+    free(log);
+}
+
+// Appends the record of an inserted element to the buffer, dropping it when the buffer is full
+void insert_log_append(insertLog_t *log, char *request, uint8_t *md5, unsigned int ttl, uint64_t generation)
+{
+    insertLogRecord_t   record;
+    size_t              length = strlen(request);
+    size_t              size = sizeof(insertLogRecord_t) + length + 1;
+
+    record.entry.expiresAt = ttl ? cache_snapshot_clock_ms() + (uint64_t)ttl * 1000 : 0;
+    memcpy(record.entry.md5, md5, MD5_DIGEST_SIZE);
+    record.entry.length = length;
+    record.checksum = insert_log_checksum(&(record.entry), request);
+
+    pthread_mutex_lock(&(log->mutex));
+
+    // The elements of a cache older than the last one saved have been flushed
+    if (generation < log->generation)
+    {
+        pthread_mutex_unlock(&(log->mutex));
+        return;
+    }
+
+    // A full buffer drops the record and is written right away, unless a compaction is in progress
+    if (log->used + size > INSERT_LOG_BUFFER_SIZE || log->stopped)
+    {
+        log->dropped++;
+        pthread_cond_signal(&(log->wake));
+    }
+    else
+    {
+        memcpy(log->buffer + log->used, &record, sizeof(insertLogRecord_t));
+        memcpy(log->buffer + log->used + sizeof(insertLogRecord_t), request, length + 1);
+        log->used += size;
+    }
+    pthread_mutex_unlock(&(log->mutex));
+}
+
+// Returns the size of the log file
+size_t insert_log_size(insertLog_t *log)
+{
+    size_t size;
+
+    pthread_mutex_lock(&(log->mutex));
+    size = log->size;
+    pthread_mutex_unlock(&(log->mutex));
+
+    return size;
+}
+
+// Pauses the writer, waiting for the write in progress, before compacting the log
+void insert_log_pause(insertLog_t *log, uint64_t generation)
+{
+    pthread_mutex_lock(&(log->mutex));
+    log->paused = true;
+    log->pausedAt = log->used;
+    if (generation > log->generation)
+        log->generation = generation;
+    while (log->writing)
+        pthread_cond_wait(&(log->written), &(log->mutex));
+    pthread_mutex_unlock(&(log->mutex));
+}
+
+// Resumes the writer after a compaction, truncating the log when the snapshot was saved
+void insert_log_resume(insertLog_t *log, bool truncate)
+{
+    pthread_mutex_lock(&(log->mutex));
+    if (truncate && ftruncate(log->fd, 0) == 0)
+    {
+        lseek(log->fd, 0, SEEK_SET);
+        log->size = 0;
+
+        // Only the records appended during the compaction are left to be written
+        memmove(log->buffer, log->buffer + log->pausedAt, log->used - log->pausedAt);
+        log->used -= log->pausedAt;
+    }
+
+    log->paused = false;
+    pthread_cond_signal(&(log->wake));
+    pthread_mutex_unlock(&(log->mutex));
+}
@@ -14,87 +14,975 @@
 #include "meteoserver.h"
 
 
+/*
+ * Concurrency model:
+ *   - Writers (inserts, evictions and recency updates) take the shard mutex.
+ *   - Hits don't take any lock: the hash chains are published with release stores, every
+ *     node carries a sequence counter (odd while a writer modifies it) that readers check
+ *     before and after copying the value, and the replaced requests are retired through the
+ *     epoch so they stay readable until every reader that could see them has finished.
+ *   - Nodes are split in two arrays of each shard, reserved as a whole and aligned to cache
+ *     lines: their hot metadata (hash, request length, sequence and 32-bit links), two nodes
+ *     per cache line, and their cold data (request, digest and expiration), a cache line per
+ *     node. Hash chains and policy queues are walked through the hot metadata alone, and
+ *     the cold data is only read once the hash and the length of a node match.
+ *   - Values are raw MD5 digests stored in the cold data, written and read as two 64-bit
+ *     words so a torn copy is always caught by the sequence check.
+ *   - Requests shorter than CACHE_INLINE_KEY_SIZE are stored in the cold data too, and only
+ *     the longer ones are allocated. Readers validate the request pointer and its length
+ *     with the sequence before comparing, so they never read past an inline buffer that's
+ *     being rewritten, nor past a retired request.
+ *   - A reader racing with a writer may report a miss for a cached request, which only
+ *     costs a recomputation: lru_cache_update_node never inserts a request twice.
+ *   - The order of the nodes is kept by the eviction policy of the cache (cachePolicy.c).
+ *     Its lock-free 'touch' is applied right away, while its 'hit' (reordering the queues)
+ *     is applied in batches, from a per-thread buffer. A batch is dropped if its shard is
+ *     busy, so under contention recency is only sampled. The buffer is also applied once its
+ *     oldest hit is RECENCY_FLUSH_MS old, and by lru_cache_drain_recency when its thread goes
+ *     idle, so the hits of a thread that serves few of them still reach the policy.
+ *   - With the TinyLFU admission filter, every access is recorded in the frequency sketch of
+ *     its shard (hits through the recency buffer) and a new request only replaces the
+ *     victim chosen by the eviction policy when it's estimated to be more frequent.
+ *   - With a byte budget, every element is charged lru_entry_size bytes, and the victims of the
+ *     policy are evicted until the new element fits. Nodes are taken from the pool on demand,
+ *     so the pages of the unused part of the pool are never touched.
+ *   - Elements with a TTL are reported as misses once they expire, and refreshed in place by
+ *     the next insertion of their request. Each shard also keeps them in a timing wheel of
+ *     TTL_WHEEL_SLOTS slots, that lru_cache_expire sweeps one tick at a time to return the
+ *     expired nodes to the free list of the shard.
+ *   - The pool and the hash index of each shard are reserved for CACHE_RESIZE_HEADROOM times
+ *     its initial capacity, so lru_cache_resize can grow or shrink the cache in place. A
+ *     shrink only lowers the limits of the shards: the elements over them are evicted by
+ *     lru_cache_trim, CACHE_EVICT_BATCH at a time, and an insert never evicts more than that.
+ *   - With a disk tier, the first DISK_TIER_DEMOTE_BATCH victims of an insert are copied while
+ *     the shard is locked and demoted to the tier (diskTier.c) once it's released, so the
+ *     shard is never locked while the file is written.
+ */
+
+
+/* Source of unique identifiers for the caches, used to discard stale recency updates */
+static uint64_t cacheGenerations = 0;
+
+/* Hits of the calling thread whose recency update is still pending */
+static __thread recencyBuffer_t recencyBuffer;
+
+
+/**
+* @brief Computes the hash of a request (64-bit FNV-1a), used to index the cache.
+* @param request Request to be hashed.
+* @return Hash of the request.
+*/
+uint64_t lru_hash_request(char *request);
+
+/**
+* @brief Computes the memory charged to the byte budget of the cache for an element: its node
+*        (hot metadata and cold data, with its digest and short request), its bucket of the hash
+*        index and its allocated request when it's too long to be stored inline.
+* @param requestLength Length of the request of the element.
+* @return Size of the element in bytes.
+*/
+size_t lru_entry_size(size_t requestLength);
+
+/**
+* @brief Stores a request in a node, inside its inline buffer when it fits. Must be called
+*        between the two halves of lru_node_write_seq.
+* @param shard Shard that contains the node.
+* @param node Node being modified.
+* @param request Request to be stored.
+* @param length Length of the request.
+*/
+static void lru_node_set_request(lruCacheShard_t *shard, lruCacheNode_t *node, char *request, size_t length);
+
+/**
+* @brief Releases the request of a node, retiring it when it was allocated. Must be called
+*        between the two halves of lru_node_write_seq.
+* @param shard Shard that contains the node.
+* @param node Node being modified.
+*/
+static void lru_node_release_request(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief Returns the current time of a monotonic clock, the one the expiration of the elements is based on.
+* @return Time in milliseconds.
+*/
+uint64_t lru_clock_ms();
+
+/**
+* @brief Selects the shard in charge of a request. The hash is scrambled first: FNV-1a barely
+*        mixes its upper bits for short keys, and its lower bits already choose the bucket.
+* @param cache Cache that contains the shards.
+* @param hash Hash of the request.
+* @return Shard that stores (or will store) the request.
+*/
+static lruCacheShard_t *lru_select_shard(lruCache_t *cache, uint64_t hash);
+
 /**
-* @brief Function in charge of searching for elements in the cache,
-*        instead of the standard hash table.
-* @param cachePool Double pointer that contains each one of the nodes of the cache.
-* @param request Request that's searched in the cache.
-* @param currentCapacity Current capacity of the cache.
+* @brief Function in charge of searching for elements in a shard through its hash index.
+* @param shard Shard that stores the elements.
+* @param request Request that's searched in the shard.
+* @param length Length of the request.
+* @param hash Hash of the request.
 * @return If exists, returns a node containing the requested element, NULL if it doesn't.
 */
-lruCacheNode_t *lru_find_element(lruCacheNode_t **cachePool, char *request, size_t currentCapacity);
+lruCacheNode_t *lru_find_element(lruCacheShard_t *shard, char *request, size_t length, uint64_t hash);
+
+/**
+* @brief Lock-free version of lru_find_element, that copies the value of the element.
+* @param shard Shard that stores the elements.
+* @param request Request that's searched in the shard.
+* @param length Length of the request.
+* @param hash Hash of the request.
+* @param md5 Buffer where the cached digest is copied.
+* @param expiry Filled with the expiration of the element, on the monotonic clock (0 if it never expires).
+* @param seq Sequence of the node at the time it was read.
+* @return If exists and hasn't expired, returns the node containing the requested element, NULL otherwise.
+*/
+static lruCacheNode_t *lru_find_element_lockless(lruCacheShard_t *shard, char *request, size_t length,
+                                                 uint64_t hash, uint8_t *md5, uint64_t *expiry, uint32_t *seq);
+
+/**
+* @brief Stores a digest in a node. Must be called between the two halves of lru_node_write_seq.
+* @param data Cold data of the node being modified.
+* @param md5 Digest to be stored.
+*/
+static void lru_node_set_md5(lruCacheNodeData_t *data, uint8_t *md5);
+
+/**
+* @brief Marks the beginning (odd sequence) or the end (even sequence) of a modification of a node.
+* @param node Node being modified.
+*/
+static void lru_node_write_seq(lruCacheNode_t *node);
+
+/**
+* @brief Stores a hit in the recency buffer of the calling thread, applying the buffer when it's full
+*        or its oldest hit is RECENCY_FLUSH_MS old.
+* @param cache Cache that contains the node.
+* @param shard Shard that contains the node.
+* @param node Node that has been hit.
+* @param seq Sequence of the node when it was hit.
+* @param hash Hash of the request, for the admission filter.
+*/
+static void lru_record_hit(lruCache_t *cache, lruCacheShard_t *shard, lruCacheNode_t *node, uint32_t seq,
+                           uint64_t hash);
+
+/**
+* @brief Applies the pending recency updates of the calling thread, one shard lock at a time.
+*        Shards whose lock is busy are skipped and their updates discarded.
+* @param cache Cache that contains the nodes.
+*/
+static void lru_drain_recency_buffer(lruCache_t *cache);
+
+/**
+* @brief Links a node into the bucket of the hash index that corresponds to its request.
+* @param shard Shard that contains the hash index.
+* @param node Node to be indexed.
+* @param hash Hash of the node's request.
+*/
+static void lru_hash_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+/**
+* @brief Unlinks a node from the hash index.
+* @param shard Shard that contains the hash index.
+* @param node Node to be removed from the index.
+*/
+static void lru_hash_remove(lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief Sets the expiration time of a node, moving it to the corresponding slot of the timing wheel.
+* @param shard Shard that contains the node.
+* @param node Node whose expiration time is set.
+* @param expiry Expiration time in milliseconds, 0 if the node never expires.
+*/
+static void lru_wheel_set_expiry(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t expiry);
+
+/**
+* @brief Evicts a node from a shard, returning it to the free list.
+* @param cache Cache that contains the shard.
+* @param shard Shard that contains the node.
+* @param node Node to be evicted.
+*/
+static void lru_evict_node(lruCache_t *cache, lruCacheShard_t *shard, lruCacheNode_t *node);
+
+/**
+* @brief Evicts a victim of the eviction policy, staging it first to be demoted to the disk tier when there's
+*        one and the batch isn't full.
+* @param cache Cache that contains the shard.
+* @param shard Shard that contains the node, locked.
+* @param node Victim to be evicted.
+* @param diskTier Disk tier of the cache, NULL if it has none.
+* @param demoted Batch of DISK_TIER_DEMOTE_BATCH victims to be demoted.
+* @param demotedCount Number of victims in the batch.
+* @return Number of victims in the batch after staging the node.
+*/
+static size_t lru_evict_victim(lruCache_t *cache, lruCacheShard_t *shard, lruCacheNode_t *node, diskTier_t *diskTier,
+                               diskTierSlot_t *demoted, size_t demotedCount);
+
+/**
+* @brief Demotes a batch of victims to the disk tier. Called once the lock of their shard is released.
+* @param cache Cache the victims were evicted from.
+* @param diskTier Disk tier of the cache.
+* @param demoted Batch of victims staged by lru_evict_victim.
+* @param demotedCount Number of victims in the batch.
+*/
+static void lru_demote_victims(lruCache_t *cache, diskTier_t *diskTier, diskTierSlot_t *demoted, size_t demotedCount);
+
+/**
+* @brief Checks if a shard would be over its capacity or its byte budget after adding some elements.
+* @param shard Shard to be checked.
+* @param elements Number of elements to be added.
+* @param bytes Bytes charged for the elements to be added.
+* @return True if the shard wouldn't fit them without evicting.
+*/
+static bool lru_shard_exceeds(lruCacheShard_t *shard, size_t elements, size_t bytes);
+
+/**
+* @brief Takes a node for a new element, from the free list or from the unused part of the pool.
+* @param shard Shard that contains the pool.
+* @return Node, with its sequence marking the beginning of a modification.
+*/
+static lruCacheNode_t *lru_alloc_node(lruCacheShard_t *shard);
+
+/**
+* @brief Inserts an element in its shard, or refreshes it in place if it's cached but has expired. The victims
+*        evicted to make room for it are demoted to the disk tier, once the lock of the shard is released.
+* @param cache Cache to be updated.
+* @param request Request to be added.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Digest to be cached along the request.
+* @param expiry Time of the monotonic clock when the element expires, 0 if it never does.
+* @param admission Whether the element has to pass the admission filter of its shard.
+* @return True if the element was inserted or refreshed, false if it was already cached or it was rejected.
+*/
+static bool lru_cache_insert(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t expiry,
+                             bool admission);
+
+/**
+* @brief Returns the size of the mapping that holds one of the arrays of a shard, rounded up to whole huge
+*        pages when the shard is meant to be backed by them.
+* @param size Size of the array.
+* @param hugePages Whether the array is backed by huge pages.
+* @return Size of the mapping.
+*/
+static size_t lru_shard_map_size(size_t size, bool hugePages);
+
+/**
+* @brief Reserves zeroed memory for one of the arrays of a shard. Reserved huge pages are claimed up front,
+*        any other backing is only faulted in once its pages are touched.
+* @param size Size of the array.
+* @param hugePages Whether the array should be backed by huge pages.
+* @param backing Backing to be tried (CACHE_PAGES_*), lowered to the one actually obtained. Reserved huge
+*        pages don't fall back: the caller retries the whole shard with another backing.
+* @return Page-aligned array, NULL if it can't be reserved.
+*/
+static void *lru_shard_map(size_t size, bool hugePages, int *backing);
+
+/**
+* @brief Reserves the node pool, the node data and the hash index of a shard for its pool capacity.
+* @param shard Shard whose arrays are reserved.
+* @return True if every array was reserved, otherwise none of them is left mapped.
+*/
+static bool lru_shard_map_pool(lruCacheShard_t *shard);
+
+/**
+* @brief Releases the node pool, the node data and the hash index of a shard.
+* @param shard Shard whose arrays are released.
+*/
+static void lru_shard_unmap_pool(lruCacheShard_t *shard);
+
+/**
+* @brief Checks whether the kernel hands out transparent huge pages to the regions that ask for them.
+* @return True unless transparent huge pages are disabled.
+*/
+static bool lru_transparent_huge_pages();
+
+/**
+* @brief Initializes an individual shard of the cache.
+* @param shard Shard to be initialized.
+* @param capacity Number of elements that'll contain the shard. Its pool has room to grow it
+*        CACHE_RESIZE_HEADROOM times, unless it's backed by reserved huge pages.
+* @param byteCapacity Byte budget of the shard, 0 if it's only limited by its number of nodes.
+* @param policy Eviction policy of the cache.
+* @param admission Whether the shard filters new requests with TinyLFU.
+* @param hugePages Whether the arrays of the shard should be backed by huge pages.
+* @return True if the arrays of the shard were reserved.
+*/
+static bool lru_shard_init(lruCacheShard_t *shard, size_t capacity, size_t byteCapacity, const cachePolicy_t *policy,
+                           bool admission, bool hugePages);
+
+/**
+* @brief Frees the data assigned to an individual shard of the cache.
+* @param shard Shard to be freed.
+* @param policy Eviction policy of the cache.
+*/
+static void lru_shard_free(lruCacheShard_t *shard, const cachePolicy_t *policy);
 
 /**
 * @brief Allocs and initializes a new lruCache_t structure.
-* @param capacity Number of nodes that'll contain the cache.
+* @param settings Server settings: cache size and byte budget, number of shards, eviction policy, admission
+*        filter, default TTL and huge pages.
 * @return Initialized cache.
 */
-lruCache_t *lru_cache_init(int capacity);
+lruCache_t *lru_cache_init(arguments_t *settings);
 
 /**
 * @brief Function in charge of freeing the data assigned to the cache.
-* @param cache Cache to be freed.
+* @param cache Cache to be freed. Nothing is done if it's NULL.
 */
 void lru_cache_free(lruCache_t *cache);
 
 /**
-* @brief Function in charge of updating and searching for cached elements.
+* @brief Returns the number of cached elements and the memory charged for them, without taking any lock.
+* @param cache Cache to be measured.
+* @param elements Filled with the number of cached elements.
+* @param bytes Filled with the bytes charged to the byte budget by the cached elements.
+*/
+void lru_cache_usage(lruCache_t *cache, size_t *elements, size_t *bytes);
+
+/**
+* @brief Applies the pending recency updates of the calling thread. Meant to be called when the thread
+*        runs out of requests, so the hits it buffered aren't held back until it serves more of them.
+* @param cache Current cache. Updates of the caches it replaced are discarded.
+*/
+void lru_cache_drain_recency(lruCache_t *cache);
+
+/**
+* @brief Returns the pages backing the arrays of the cache: the weakest backing obtained by any of them.
+* @param cache Cache to be checked.
+* @return "explicit" for reserved huge pages, "transparent" for transparent huge pages, "none" for regular pages.
+*/
+const char *lru_cache_page_backing(lruCache_t *cache);
+
+/**
+* @brief Function in charge of updating and searching for cached elements, without taking any lock.
+* @param cache Cache that stores the elements.
+* @param request Request to be searched in the queue.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Buffer (MD5_DIGEST_SIZE bytes) where the cached digest is copied.
+* @param expiry Filled with the expiration of the element on the monotonic clock (0 if it never expires), unless it's NULL.
+* @return If exists, returns the buffer with the cached digest corresponding to the request. NULL if it doesn't.
+*/
+uint8_t *lru_cache_get_element(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry);
+
+/**
+* @brief Same as lru_cache_get_element, but the lookup isn't counted in the statistics of the cache. Meant
+*        for a request that's looked up again after missing, so its miss is only counted once.
 * @param cache Cache that stores the elements.
 * @param request Request to be searched in the queue.
-* @return If exists, returns the cached element corresponding to the request. NULL if it doesn't.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Buffer (MD5_DIGEST_SIZE bytes) where the cached digest is copied.
+* @param expiry Filled with the expiration of the element on the monotonic clock (0 if it never expires), unless it's NULL.
+* @return If exists, returns the buffer with the cached digest corresponding to the request. NULL if it doesn't.
+*/
+uint8_t *lru_cache_peek_element(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry);
+
+/**
+* @brief Searches for a batch of requests, without taking any lock. The memory their lookups need is
+*        prefetched CACHE_PREFETCH_BATCH requests at a time, so the cache misses of their lookups overlap
+*        instead of being paid one after another.
+* @param cache Cache that stores the elements.
+* @param requests Requests to be searched.
+* @param hashes Hash of each request, as computed by lru_hash_request.
+* @param count Number of requests.
+* @param md5s Buffer (count * MD5_DIGEST_SIZE bytes) where the cached digest of each request is copied.
+* @param found Filled with whether each request is cached.
+* @return Number of requests found in the cache.
 */
-char    *lru_cache_get_element(lruCache_t *cache, char *request);
+size_t lru_cache_get_many(lruCache_t *cache, char **requests, uint64_t *hashes, size_t count, uint8_t *md5s,
+                          bool *found);
 
 /**
 * @brief Function in charge of updating the cache with a new element.
 * @param cache Cache to be updated.
 * @param request Request to be added to the queue.
-* @param value Value to be cached along the request.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Digest (MD5_DIGEST_SIZE bytes) to be cached along the request. It's copied into the cache.
+* @param ttl Seconds until the element expires, 0 to use the default TTL of the cache.
+* @param expiry If not NULL, filled with the time of the monotonic clock when the element expires, 0 if it never
+*        does.
+* @return True if the element was inserted, false if it was already cached or it was rejected.
+*/
+bool lru_cache_update_node(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, unsigned int ttl,
+                           uint64_t *expiry);
+
+/**
+* @brief Restores an element saved from another cache, as the most recently used one of its shard. Unlike
+*        lru_cache_update_node, it's never rejected by the admission filter.
+* @param cache Cache to be updated.
+* @param request Request to be added.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param md5 Digest (MD5_DIGEST_SIZE bytes) to be cached along the request.
+* @param expiry Time of the monotonic clock when the element expires, 0 if it never does.
+* @return True if the element was restored, false if it was already cached or it doesn't fit in its shard.
+*/
+bool lru_cache_restore_node(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t expiry);
+
+/**
+* @brief Evicts the expired elements of the ticks of the timing wheels elapsed since the last call.
+* @param cache Cache whose elements are expired.
+*/
+void lru_cache_expire(lruCache_t *cache);
+
+/**
+* @brief Changes the capacity and the byte budget of the cache without flushing it. Only the limits of the
+*        shards are changed: the elements over them are evicted afterwards by lru_cache_trim.
+* @param cache Cache to be resized.
+* @param capacity New number of elements, 0 to fit as many as the byte budget allows. It's limited to
+*        the pools reserved when the cache was created.
+* @param bytes New byte budget, 0 if it's only limited by its number of elements.
+* @return Number of elements the cache can hold after the resize.
+*/
+size_t lru_cache_resize(lruCache_t *cache, size_t capacity, size_t bytes);
+
+/**
+* @brief Evicts up to CACHE_EVICT_BATCH elements from each shard over its limits, holding its lock only
+*        for that batch.
+* @param cache Cache being shrunk.
+* @return True while there are shards over their limits.
 */
-void lru_cache_update_node(lruCache_t *cache, char *request, char *value);
+bool lru_cache_trim(lruCache_t *cache);
 
 
 
 /* Definitions */
 
 
-// Function in charge of searching for elements in the cache, instead of the standard hash table
-lruCacheNode_t *lru_find_element(lruCacheNode_t **cachePool, char *request, size_t currentCapacity)
+// Computes the hash of a request (64-bit FNV-1a), used to index the cache
+uint64_t lru_hash_request(char *request)
 {
-    lruCacheNode_t *ret = NULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
 
-    for (size_t i = 0; i < currentCapacity; i++)
+    for (unsigned char *c = (unsigned char *)request; *c; c++)
     {
-        if (cachePool[i]->request && request && !strcmp(request, cachePool[i]->request)) 
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+// Computes the memory charged to the byte budget of the cache for an element
+size_t lru_entry_size(size_t requestLength)
+{
+    size_t size = sizeof(lruCacheNode_t) + sizeof(lruCacheNodeData_t) + sizeof(uint32_t);
+
+    return requestLength < CACHE_INLINE_KEY_SIZE ? size : size + requestLength + 1;
+}
+
+// Returns the current time of a monotonic clock
+uint64_t lru_clock_ms()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Selects the shard in charge of a request
+static lruCacheShard_t *lru_select_shard(lruCache_t *cache, uint64_t hash)
+{
+    uint64_t mixed = (hash * 0x9e3779b97f4a7c15ULL) >> 32;
+
+    return &(cache->shards[(mixed * cache->shardNumber) >> 32]);
+}
+
+// Function in charge of searching for elements in a shard through its hash index
+lruCacheNode_t *lru_find_element(lruCacheShard_t *shard, char *request, size_t length, uint64_t hash)
+{
+    lruCacheNode_t *node;
+
+    for (uint32_t index = shard->hashTable[hash & shard->hashMask]; index != CACHE_NIL; index = node->hashNext)
+    {
+        node = cache_node(shard, index);
+        if (node->hash == hash && node->requestLength == length &&
+            !memcmp(request, cache_node_data(shard, node)->request, length))
+            return node;
+    }
+
+    return NULL;
+}
+
+// Lock-free version of lru_find_element, that copies the value of the element
+static lruCacheNode_t *lru_find_element_lockless(lruCacheShard_t *shard, char *request, size_t length,
+                                                 uint64_t hash, uint8_t *md5, uint64_t *expiry, uint32_t *seq)
+{
+    lruCacheNode_t      *node;
+    lruCacheNodeData_t  *data;
+    char                *nodeRequest;
+    uint64_t            nodeMd5[MD5_DIGEST_SIZE / sizeof(uint64_t)];
+    uint32_t            index;
+
+    index = load_acquire(shard->hashTable[hash & shard->hashMask]);
+
+    // Nodes can be recycled while they're traversed, so the walk is bounded. Links are always
+    // indices of the pool, so a recycled node can't lead the walk out of it
+    for (size_t steps = 0; index != CACHE_NIL && steps <= shard->poolCapacity; steps++)
+    {
+        node = cache_node(shard, index);
+        *seq = load_acquire(node->seq);
+
+        // The cold data is only read once the hash and the length match
+        if (!(*seq & 1) && load_relaxed(node->hash) == hash && load_relaxed(node->requestLength) == length)
+        {
+            data = cache_node_data(shard, node);
+            nodeRequest = load_relaxed(data->request);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (nodeRequest && load_relaxed(node->seq) == *seq && !memcmp(request, nodeRequest, length))
+            {
+                nodeMd5[0] = load_relaxed(data->md5[0]);
+                nodeMd5[1] = load_relaxed(data->md5[1]);
+                *expiry = load_relaxed(data->expiry);
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+                // The node was modified while it was being read
+                if (load_relaxed(node->seq) != *seq)
+                    return NULL;
+
+                memcpy(md5, nodeMd5, MD5_DIGEST_SIZE);
+
+                return !*expiry || *expiry > lru_clock_ms() ? node : NULL;
+            }
+        }
+
+        index = load_acquire(node->hashNext);
+    }
+
+    return NULL;
+}
+
+// Stores a request in a node, inside its inline buffer when it fits
+static void lru_node_set_request(lruCacheShard_t *shard, lruCacheNode_t *node, char *request, size_t length)
+{
+    lruCacheNodeData_t  *data = cache_node_data(shard, node);
+    char                *nodeRequest = data->inlineRequest;
+
+    if (length < CACHE_INLINE_KEY_SIZE)
+        memcpy(data->inlineRequest, request, length + 1);
+    else
+        nodeRequest = strdup(request);
+
+    store_relaxed(node->requestLength, length);
+    store_relaxed(data->request, nodeRequest);
+}
+
+// Releases the request of a node, retiring it when it was allocated
+static void lru_node_release_request(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    lruCacheNodeData_t *data = cache_node_data(shard, node);
+
+    if (data->request != data->inlineRequest)
+        epoch_retire(data->request);
+
+    store_relaxed(data->request, NULL);
+    store_relaxed(node->requestLength, 0);
+}
+
+// Stores a digest in a node
+static void lru_node_set_md5(lruCacheNodeData_t *data, uint8_t *md5)
+{
+    uint64_t words[MD5_DIGEST_SIZE / sizeof(uint64_t)];
+
+    memcpy(words, md5, MD5_DIGEST_SIZE);
+    store_relaxed(data->md5[0], words[0]);
+    store_relaxed(data->md5[1], words[1]);
+}
+
+// Marks the beginning (odd sequence) or the end (even sequence) of a modification of a node
+static void lru_node_write_seq(lruCacheNode_t *node)
+{
+    if (node->seq & 1)
+        store_release(node->seq, node->seq + 1);
+    else
+    {
+        store_relaxed(node->seq, node->seq + 1);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+}
+
+// Stores a hit in the recency buffer of the calling thread, applying the buffer when it's full or old
+static void lru_record_hit(lruCache_t *cache, lruCacheShard_t *shard, lruCacheNode_t *node, uint32_t seq,
+                           uint64_t hash)
+{
+    recencyEntry_t  *entry = &(recencyBuffer.entries[recencyBuffer.count++]);
+    uint64_t        now = lru_clock_ms();
+
+    if (recencyBuffer.count == 1)
+        recencyBuffer.since = now;
+
+    entry->generation = cache->generation;
+    entry->hash = hash;
+    entry->node = node;
+    entry->shard = shard - cache->shards;
+    entry->seq = seq;
+
+    if (recencyBuffer.count == RECENCY_BUFFER_SIZE || now - recencyBuffer.since >= RECENCY_FLUSH_MS)
+        lru_drain_recency_buffer(cache);
+}
+
+// Applies the pending recency updates of the calling thread, one shard lock at a time
+static void lru_drain_recency_buffer(lruCache_t *cache)
+{
+    recencyEntry_t  *entries = recencyBuffer.entries;
+    lruCacheShard_t *shard;
+    bool            locked;
+
+    for (size_t i = 0; i < recencyBuffer.count; i++)
+    {
+        // Updates of a cache that has been replaced are simply dropped
+        if (entries[i].generation != cache->generation)
+            continue;
+
+        shard = &(cache->shards[entries[i].shard]);
+        locked = pthread_mutex_trylock(&(shard->mutex)) == 0;
+
+        // Apply (or discard) every pending update of this shard under the same lock
+        for (size_t j = i; j < recencyBuffer.count; j++)
         {
-            ret = cachePool[i];
-            break;
+            if (entries[j].generation != cache->generation || entries[j].shard != entries[i].shard)
+                continue;
+
+            if (locked && shard->admission)
+                tiny_lfu_increment(shard->admission, entries[j].hash);
+
+            // The node may have been recycled for another request since it was hit
+            if (locked && cache->policy->hit && entries[j].node->seq == entries[j].seq)
+                cache->policy->hit(shard, entries[j].node);
+            entries[j].generation = 0;
         }
+
+        if (locked)
+            pthread_mutex_unlock(&(shard->mutex));
+    }
+
+    recencyBuffer.count = 0;
+}
+
+// Links a node into the bucket of the hash index that corresponds to its request
+static void lru_hash_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    uint32_t *bucket = &(shard->hashTable[hash & shard->hashMask]);
+
+    store_relaxed(node->hashNext, *bucket);
+    store_release(*bucket, cache_node_index(shard, node));
+}
+
+// Unlinks a node from the hash index
+static void lru_hash_remove(lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    uint32_t *link = &(shard->hashTable[node->hash & shard->hashMask]);
+    uint32_t index = cache_node_index(shard, node);
+
+    while (*link != CACHE_NIL && *link != index)
+        link = &(cache_node(shard, *link)->hashNext);
+
+    // The node keeps its own link, so readers standing on it can go on with their walk
+    if (*link != CACHE_NIL)
+        store_release(*link, node->hashNext);
+}
+
+// Sets the expiration time of a node, moving it to the corresponding slot of the timing wheel
+static void lru_wheel_set_expiry(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t expiry)
+{
+    lruCacheNodeData_t  *data = cache_node_data(shard, node);
+    uint32_t            *slot;
+
+    if (data->expiry)
+    {
+        slot = &(shard->timingWheel[(data->expiry / TTL_WHEEL_TICK_MS) % TTL_WHEEL_SLOTS]);
+        if (data->wheelPrev != CACHE_NIL)
+            shard->nodeData[data->wheelPrev].wheelNext = data->wheelNext;
+        else
+            *slot = data->wheelNext;
+        if (data->wheelNext != CACHE_NIL)
+            shard->nodeData[data->wheelNext].wheelPrev = data->wheelPrev;
+        store_relaxed(shard->expiringCount, shard->expiringCount - 1);
+    }
+
+    store_relaxed(data->expiry, expiry);
+    data->wheelNext = CACHE_NIL;
+    data->wheelPrev = CACHE_NIL;
+
+    if (expiry)
+    {
+        slot = &(shard->timingWheel[(expiry / TTL_WHEEL_TICK_MS) % TTL_WHEEL_SLOTS]);
+        data->wheelNext = *slot;
+        if (*slot != CACHE_NIL)
+            shard->nodeData[*slot].wheelPrev = cache_node_index(shard, node);
+        *slot = cache_node_index(shard, node);
+        store_relaxed(shard->expiringCount, shard->expiringCount + 1);
+    }
+}
+
+// Evicts a node from a shard, returning it to the free list
+static void lru_evict_node(lruCache_t *cache, lruCacheShard_t *shard, lruCacheNode_t *node)
+{
+    shard->usedBytes -= lru_entry_size(node->requestLength);
+
+    lru_node_write_seq(node);
+    cache->policy->remove(shard, node, node->hash);
+    lru_hash_remove(shard, node);
+    lru_wheel_set_expiry(shard, node, 0);
+    lru_node_release_request(shard, node);
+    node->used = false;
+    lru_node_write_seq(node);
+
+    node->next = shard->freeNodes;
+    shard->freeNodes = cache_node_index(shard, node);
+    shard->currentCapacity--;
+}
+
+// Evicts a victim of the eviction policy, staging it first to be demoted to the disk tier
+static size_t lru_evict_victim(lruCache_t *cache, lruCacheShard_t *shard, lruCacheNode_t *node, diskTier_t *diskTier,
+                               diskTierSlot_t *demoted, size_t demotedCount)
+{
+    lruCacheNodeData_t *data = cache_node_data(shard, node);
+
+    if (diskTier && demotedCount < DISK_TIER_DEMOTE_BATCH &&
+        disk_tier_stage(&(demoted[demotedCount]), data->request, node->requestLength, node->hash,
+                        (uint8_t *)data->md5, data->expiry))
+        demotedCount++;
+    lru_evict_node(cache, shard, node);
+    cache_stats_add(evictions, 1);
+
+    return demotedCount;
+}
+
+// Demotes a batch of victims to the disk tier
+static void lru_demote_victims(lruCache_t *cache, diskTier_t *diskTier, diskTierSlot_t *demoted, size_t demotedCount)
+{
+    for (size_t i = 0; i < demotedCount; i++)
+        disk_tier_put(diskTier, &(demoted[i]), cache->generation);
+    cache_stats_add(demotions, demotedCount);
+}
+
+// Checks if a shard would be over its capacity or its byte budget after adding some elements
+static bool lru_shard_exceeds(lruCacheShard_t *shard, size_t elements, size_t bytes)
+{
+    return shard->currentCapacity + elements > shard->totalCapacity ||
+           (shard->byteCapacity && shard->usedBytes + bytes > shard->byteCapacity);
+}
+
+// Takes a node for a new element, from the free list or from the unused part of the pool
+static lruCacheNode_t *lru_alloc_node(lruCacheShard_t *shard)
+{
+    lruCacheNode_t *node;
+
+    if (shard->freeNodes != CACHE_NIL)
+    {
+        node = cache_node(shard, shard->freeNodes);
+        shard->freeNodes = node->next;
+        node->next = CACHE_NIL;
+    }
+    else
+        node = cache_node(shard, shard->poolUsed++);
+
+    lru_node_write_seq(node);
+    node->used = true;
+    shard->currentCapacity++;
+    return node;
+}
+
+// Reserves zeroed memory for one of the arrays of a shard
+static void *lru_shard_map(size_t size, bool hugePages, int *backing)
+{
+    void *data;
+
+    size = lru_shard_map_size(size, hugePages);
+
+    // Reserved huge pages are claimed up front (no MAP_NORESERVE): running out of them later would
+    // raise a SIGBUS on the first touch, instead of failing here and falling back
+    if (*backing == CACHE_PAGES_EXPLICIT)
+    {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        return data != MAP_FAILED ? data : NULL;
+    }
+
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    if (hugePages == false || madvise(data, size, MADV_HUGEPAGE) < 0)
+        *backing = CACHE_PAGES_SMALL;
+
+    return data;
+}
+
+// Reserves the node pool, the node data and the hash index of a shard for its pool capacity
+static bool lru_shard_map_pool(lruCacheShard_t *shard)
+{
+    // The hash index has a power-of-two number of buckets, at least as many as nodes
+    shard->hashMask = 1;
+    while (shard->hashMask < shard->poolCapacity)
+        shard->hashMask <<= 1;
+    shard->hashMask--;
+
+    shard->cachePool = lru_shard_map((shard->poolCapacity + 1) * sizeof(lruCacheNode_t), shard->hugePages,
+                                     &(shard->pageBacking));
+    shard->nodeData = lru_shard_map((shard->poolCapacity + 1) * sizeof(lruCacheNodeData_t), shard->hugePages,
+                                    &(shard->pageBacking));
+    shard->hashTable = lru_shard_map((shard->hashMask + 1) * sizeof(uint32_t), shard->hugePages,
+                                     &(shard->pageBacking));
+    if (shard->cachePool && shard->nodeData && shard->hashTable)
+        return true;
+
+    lru_shard_unmap_pool(shard);
+    return false;
+}
+
+// Releases the node pool, the node data and the hash index of a shard
+static void lru_shard_unmap_pool(lruCacheShard_t *shard)
+{
+    if (shard->cachePool)
+        munmap(shard->cachePool, lru_shard_map_size((shard->poolCapacity + 1) * sizeof(lruCacheNode_t),
+                                                    shard->hugePages));
+    if (shard->nodeData)
+        munmap(shard->nodeData, lru_shard_map_size((shard->poolCapacity + 1) * sizeof(lruCacheNodeData_t),
+                                                   shard->hugePages));
+    if (shard->hashTable)
+        munmap(shard->hashTable, lru_shard_map_size((shard->hashMask + 1) * sizeof(uint32_t), shard->hugePages));
+    shard->cachePool = NULL;
+    shard->nodeData = NULL;
+    shard->hashTable = NULL;
+}
+
+// Returns the size of the mapping that holds one of the arrays of a shard
+static size_t lru_shard_map_size(size_t size, bool hugePages)
+{
+    if (hugePages)
+        size = (size + CACHE_HUGE_PAGE_SIZE - 1) & ~((size_t)CACHE_HUGE_PAGE_SIZE - 1);
+
+    return size;
+}
+
+// Checks whether the kernel hands out transparent huge pages to the regions that ask for them
+static bool lru_transparent_huge_pages()
+{
+    FILE    *file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    char    modes[64] = {0};
+
+    if (file == NULL)
+        return false;
+    if (fgets(modes, sizeof(modes), file) == NULL)
+        modes[0] = '\0';
+    fclose(file);
+
+    return strstr(modes, "[never]") == NULL;
+}
+
+// Initializes an individual shard of the cache
+static bool lru_shard_init(lruCacheShard_t *shard, size_t capacity, size_t byteCapacity, const cachePolicy_t *policy,
+                           bool admission, bool hugePages)
+{
+    // Nodes are allocated contiguously, so the clock hand sweeps them in order. The first node is CACHE_NIL.
+    // Reserved huge pages are claimed as soon as they're mapped, so they only hold the current capacity
+    shard->hugePages = hugePages;
+    shard->pageBacking = CACHE_PAGES_EXPLICIT;
+    shard->poolCapacity = capacity < UINT32_MAX - 1 ? capacity : UINT32_MAX - 1;
+    if (hugePages == false || lru_shard_map_pool(shard) == false)
+    {
+        // Otherwise the pool is reserved for the largest size the shard can be resized to (as far as
+        // 32-bit links reach), its pages are only touched once its nodes are used
+        shard->pageBacking = CACHE_PAGES_TRANSPARENT;
+        shard->poolCapacity = capacity * CACHE_RESIZE_HEADROOM;
+        if (shard->poolCapacity >= UINT32_MAX)
+            shard->poolCapacity = UINT32_MAX - 1;
+        if (lru_shard_map_pool(shard) == false)
+            return false;
+    }
+    if (capacity > shard->poolCapacity)
+        capacity = shard->poolCapacity;
+    shard->freeNodes = CACHE_NIL;
+    shard->poolUsed = 1;
+
+    shard->timingWheel = calloc(TTL_WHEEL_SLOTS, sizeof(uint32_t));
+    shard->wheelTick = lru_clock_ms() / TTL_WHEEL_TICK_MS;
+    shard->expiringCount = 0;
+    shard->clockHand = 0;
+    shard->admission = admission ? tiny_lfu_init(capacity) : NULL;
+    shard->totalCapacity = capacity;
+    shard->currentCapacity = 0;
+    shard->byteCapacity = byteCapacity;
+    shard->usedBytes = 0;
+    pthread_mutex_init(&(shard->mutex), NULL);
+
+    if (policy->init)
+        policy->init(shard);
+
+    return true;
+}
+
+// Frees the data assigned to an individual shard of the cache
+static void lru_shard_free(lruCacheShard_t *shard, const cachePolicy_t *policy)
+{
+    pthread_mutex_lock(&(shard->mutex));
+    for (size_t i = CACHE_NIL + 1; i < shard->poolUsed; i++)
+    {
+        if (shard->nodeData[i].request != shard->nodeData[i].inlineRequest)
+            safe_free(shard->nodeData[i].request);
     }
 
-    return ret;
+    lru_shard_unmap_pool(shard);
+    safe_free(shard->timingWheel);
+    shard->freeNodes = CACHE_NIL;
+    tiny_lfu_free(shard->admission);
+    shard->admission = NULL;
+    if (policy->free)
+        policy->free(shard);
+    shard->totalCapacity = 0;
+    shard->poolCapacity = 0;
+    shard->poolUsed = 0;
+    shard->currentCapacity = 0;
+    shard->usedBytes = 0;
+    pthread_mutex_unlock(&(shard->mutex));
+    pthread_mutex_destroy(&(shard->mutex));
 }
 
 // Allocs and initializes a new lruCache_t structure
-lruCache_t *lru_cache_init(int capacity)
+lruCache_t *lru_cache_init(arguments_t *settings)
 {
-    lruCache_t *cache = NULL;
+    lruCache_t  *cache = NULL;
+    int         capacity = settings->cacheSize;
+    int         shardNumber = settings->shardNumber;
+    size_t      bytes = settings->cacheBytes;
 
-    if (capacity <= 0)
+    if (capacity <= 0 || shardNumber <= 0)
         return NULL;
 
+    // Every shard needs at least one node
+    if (shardNumber > capacity)
+        shardNumber = capacity;
+
     cache = calloc(1, sizeof(lruCache_t));
-    cache->cachePool = calloc(capacity, sizeof(lruCacheNode_t *));
+    cache->shards = aligned_alloc(CACHE_LINE_SIZE, shardNumber * sizeof(lruCacheShard_t));
+    memset(cache->shards, 0, shardNumber * sizeof(lruCacheShard_t));
+    cache->shardNumber = shardNumber;
+    cache->totalCapacity = capacity;
+    cache->totalBytes = bytes;
+    cache->generation = __atomic_add_fetch(&cacheGenerations, 1, __ATOMIC_RELAXED);
+    cache->policy = settings->policy ? settings->policy : &lruPolicy;
+    cache->defaultTtl = settings->ttl;
 
-    for (int i = 0; i < capacity; i++)
-        cache->cachePool[i] = calloc(1, sizeof(lruCacheNode_t));
+    // Split the capacity and the byte budget between the shards, spreading the remainder over the first ones
+    cache->pageBacking = CACHE_PAGES_EXPLICIT;
+    for (int i = 0; i < shardNumber; i++)
+    {
+        if (lru_shard_init(&(cache->shards[i]), capacity / shardNumber + (i < capacity % shardNumber),
+                           bytes / shardNumber + ((size_t)i < bytes % shardNumber), cache->policy,
+                           settings->admission, settings->hugePages) == false)
+        {
+            fprintf(stderr, "Error: Can't reserve the memory of the cache: '%s'.\n", strerror(errno));
+            cache->shardNumber = i;
+            lru_cache_free(cache);
+            free(cache);
+            return NULL;
+        }
+        if (cache->shards[i].pageBacking < cache->pageBacking)
+            cache->pageBacking = cache->shards[i].pageBacking;
+    }
 
-    cache->head = cache->cachePool[0];
-    cache->head->next = cache->head;
-    cache->head->prev = cache->head;
-    cache->totalCapacity = capacity;
-    cache->currentCapacity = 0;
-    pthread_mutex_init(&(cache->mutex), NULL);
+    // Regions can ask for transparent huge pages even when the kernel never hands them out
+    if (cache->pageBacking == CACHE_PAGES_TRANSPARENT && lru_transparent_huge_pages() == false)
+        cache->pageBacking = CACHE_PAGES_SMALL;
 
     return cache;
 }
@@ -102,73 +990,381 @@ lruCache_t *lru_cache_init(int capacity)
 // Function in charge of freeing the data assigned to the cache
 void lru_cache_free(lruCache_t *cache)
 {
-    pthread_mutex_lock(&(cache->mutex));
-    for (size_t i = 0; i < cache->totalCapacity; i++)
+    if (cache == NULL)
+        return;
+
+    for (size_t i = 0; i < cache->shardNumber; i++)
+        lru_shard_free(&(cache->shards[i]), cache->policy);
+
+    safe_free(cache->shards);
+    cache->shardNumber = 0;
+    cache->totalCapacity = 0;
+}
+
+// Returns the number of cached elements and the memory charged for them, without taking any lock
+void lru_cache_usage(lruCache_t *cache, size_t *elements, size_t *bytes)
+{
+    *elements = 0;
+    *bytes = 0;
+    for (size_t i = 0; i < cache->shardNumber; i++)
     {
-        safe_free(cache->cachePool[i]->request);
-        safe_free(cache->cachePool[i]->md5);
-        safe_free(cache->cachePool[i]);
+        *elements += load_relaxed(cache->shards[i].currentCapacity);
+        *bytes += load_relaxed(cache->shards[i].usedBytes);
     }
+}
 
-    safe_free(cache->cachePool);
-    cache->totalCapacity = 0;
-    cache->currentCapacity = 0;
-    pthread_mutex_unlock(&(cache->mutex));
+// Applies the pending recency updates of the calling thread
+void lru_cache_drain_recency(lruCache_t *cache)
+{
+    if (recencyBuffer.count)
+        lru_drain_recency_buffer(cache);
+}
+
+// Returns the pages backing the arrays of the cache
+const char *lru_cache_page_backing(lruCache_t *cache)
+{
+    if (cache->pageBacking == CACHE_PAGES_EXPLICIT)
+        return "explicit";
+    if (cache->pageBacking == CACHE_PAGES_TRANSPARENT)
+        return "transparent";
+    return "none";
+}
+
+// Function in charge of updating and searching for cached elements, without taking any lock
+uint8_t *lru_cache_get_element(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry)
+{
+    uint8_t *found = lru_cache_peek_element(cache, request, hash, md5, expiry);
+
+    if (found)
+        cache_stats_add(hits, 1);
+    else
+        cache_stats_add(misses, 1);
+
+    return found;
+}
+
+// Same as lru_cache_get_element, without counting the lookup in the statistics
+uint8_t *lru_cache_peek_element(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t *expiry)
+{
+    lruCacheShard_t *shard;
+    lruCacheNode_t  *tmpNode;
+    uint64_t        nodeExpiry;
+    uint32_t        seq;
+    size_t          length;
+
+    if (!request)
+        return NULL;
+
+    length = strlen(request);
+    shard = lru_select_shard(cache, hash);
+
+    epoch_enter();
+    tmpNode = lru_find_element_lockless(shard, request, length, hash, md5, &nodeExpiry, &seq);
+    if (tmpNode && expiry)
+        *expiry = nodeExpiry;
+
+    // The policy is touched right away, its queues are reordered later on through the
+    // buffer. The admission filter also counts hits through the buffer
+    if (tmpNode && cache->policy->touch)
+        cache->policy->touch(tmpNode);
+    if (tmpNode && (cache->policy->hit || shard->admission))
+        lru_record_hit(cache, shard, tmpNode, seq, hash);
+    epoch_exit();
+
+    return tmpNode ? md5 : NULL;
 }
 
-// Function in charge of updating and searching for cached elements
-char    *lru_cache_get_element(lruCache_t *cache, char *request)
+// Searches for a batch of requests, prefetching the memory of each one before resolving any of them
+size_t lru_cache_get_many(lruCache_t *cache, char **requests, uint64_t *hashes, size_t count, uint8_t *md5s,
+                          bool *found)
 {
-    lruCacheNode_t *tmpNode;
+    lruCacheShard_t *shards[CACHE_PREFETCH_BATCH];
+    lruCacheNode_t  *tmpNode;
+    uint64_t        hash;
+    uint64_t        expiry;
+    uint32_t        index;
+    uint32_t        seq;
+    size_t          batch;
+    size_t          hits = 0;
 
-    pthread_mutex_lock(&(cache->mutex));
-    tmpNode = lru_find_element(cache->cachePool, request, cache->currentCapacity);
-    
-    // Move the node to the head of the list if "request" is present in the cache
-    if (tmpNode && tmpNode != cache->head)
+    epoch_enter();
+    for (size_t first = 0; first < count; first += batch)
     {
-	    tmpNode->prev->next = tmpNode->next;
-	    tmpNode->next->prev = tmpNode->prev;
-	    tmpNode->next = cache->head;
-	    tmpNode->prev = cache->head->prev;
-	    tmpNode->prev->next = tmpNode;
-	    tmpNode->next->prev = tmpNode;
+        batch = count - first < CACHE_PREFETCH_BATCH ? count - first : CACHE_PREFETCH_BATCH;
+
+        // The buckets of the whole batch are requested first, then the first node of each one,
+        // both its metadata and its data, which holds the request and the digest on a hit
+        for (size_t i = 0; i < batch; i++)
+        {
+            shards[i] = lru_select_shard(cache, hashes[first + i]);
+            __builtin_prefetch(&(shards[i]->hashTable[hashes[first + i] & shards[i]->hashMask]));
+        }
+        for (size_t i = 0; i < batch; i++)
+        {
+            index = load_relaxed(shards[i]->hashTable[hashes[first + i] & shards[i]->hashMask]);
+            if (index == CACHE_NIL)
+                continue;
+            __builtin_prefetch(cache_node(shards[i], index));
+            __builtin_prefetch(&(shards[i]->nodeData[index]));
+        }
+
+        // By the time they're resolved, most of their memory is already on its way
+        for (size_t i = 0; i < batch; i++)
+        {
+            hash = hashes[first + i];
+            tmpNode = lru_find_element_lockless(shards[i], requests[first + i], strlen(requests[first + i]),
+                                                hash, md5s + (first + i) * MD5_DIGEST_SIZE, &expiry, &seq);
+            if (tmpNode && cache->policy->touch)
+                cache->policy->touch(tmpNode);
+            if (tmpNode && (cache->policy->hit || shards[i]->admission))
+                lru_record_hit(cache, shards[i], tmpNode, seq, hash);
 
-        cache->head = tmpNode;
+            found[first + i] = tmpNode != NULL;
+            hits += tmpNode != NULL;
+        }
     }
-    pthread_mutex_unlock(&(cache->mutex));
+    epoch_exit();
 
-    return tmpNode ? tmpNode->md5 : NULL;
+    cache_stats_add(hits, hits);
+    cache_stats_add(misses, count - hits);
+    return hits;
 }
 
 // Function in charge of updating the cache with a new element
-void lru_cache_update_node(lruCache_t *cache, char *request, char *value)
+bool lru_cache_update_node(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, unsigned int ttl,
+                           uint64_t *expiry)
+{
+    uint64_t expiresAt = 0;
+
+    if (!ttl)
+        ttl = cache->defaultTtl;
+    if (ttl)
+        expiresAt = lru_clock_ms() + (uint64_t)ttl * 1000;
+    if (expiry)
+        *expiry = expiresAt;
+
+    return lru_cache_insert(cache, request, hash, md5, expiresAt, true);
+}
+
+// Restores an element saved from another cache, as the most recently used one of its shard
+bool lru_cache_restore_node(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t expiry)
+{
+    return lru_cache_insert(cache, request, hash, md5, expiry, false);
+}
+
+// Inserts an element in its shard, or refreshes it in place if it's cached but has expired
+static bool lru_cache_insert(lruCache_t *cache, char *request, uint64_t hash, uint8_t *md5, uint64_t expiry,
+                             bool admission)
 {
-    lruCacheNode_t *tmpNode = NULL;
+    lruCacheShard_t     *shard;
+    lruCacheNode_t      *tmpNode = NULL;
+    diskTier_t          *diskTier = load_relaxed(cache->diskTier);
+    diskTierSlot_t      demoted[DISK_TIER_DEMOTE_BATCH];
+    size_t              length;
+    size_t              entrySize;
+    size_t              evicted;
+    size_t              demotedCount = 0;
+    bool                admitted = true;
+    bool                refreshed = false;
 
-    pthread_mutex_lock(&(cache->mutex));
-    // When the cache is not full, sets a new node from the pool
-    if (cache->currentCapacity < cache->totalCapacity)
+    length = strlen(request);
+    entrySize = lru_entry_size(length);
+    shard = lru_select_shard(cache, hash);
+
+    pthread_mutex_lock(&(shard->mutex));
+    // Another thread may have inserted the same request since it missed in the cache,
+    // or the request missed because it expired: then its value is refreshed in place
+    if ((tmpNode = lru_find_element(shard, request, length, hash)))
     {
-	    tmpNode = cache->cachePool[cache->currentCapacity];
-	    tmpNode->request = strdup(request);
-	    tmpNode->md5 = value;
-	    tmpNode->next = cache->head;
-	    tmpNode->prev = cache->head->prev;
-	    tmpNode->prev->next = tmpNode;
-	    tmpNode->next->prev = tmpNode;
-        cache->currentCapacity++;
+        if (cache_node_data(shard, tmpNode)->expiry && cache_node_data(shard, tmpNode)->expiry <= lru_clock_ms())
+        {
+            refreshed = true;
+            lru_node_write_seq(tmpNode);
+            lru_node_set_md5(cache_node_data(shard, tmpNode), md5);
+            lru_wheel_set_expiry(shard, tmpNode, expiry);
+            lru_node_write_seq(tmpNode);
+        }
+
+        if (cache->policy->touch)
+            cache->policy->touch(tmpNode);
+        if (cache->policy->hit)
+            cache->policy->hit(shard, tmpNode);
+        pthread_mutex_unlock(&(shard->mutex));
+        return refreshed;
     }
-    // Update oldest node when the cache is full
+
+    if (admission && shard->admission)
+        tiny_lfu_increment(shard->admission, hash);
+
+    // Elements bigger than the whole byte budget of the shard are never cached
+    if (shard->byteCapacity && entrySize > shard->byteCapacity)
+    {
+        pthread_mutex_unlock(&(shard->mutex));
+        cache_stats_add(rejections, 1);
+        return false;
+    }
+
+    // Evict the victims of the policy until there's a free node and the new element fits.
+    // Their old requests may still be read by a hit. A shard that has just been shrunk may
+    // need more victims than an insert can evict: the element is dropped, and the rest of
+    // the shrink is left to lru_cache_trim
+    for (evicted = 0; admitted && lru_shard_exceeds(shard, 1, entrySize); evicted++)
+    {
+        tmpNode = evicted < CACHE_EVICT_BATCH ? cache->policy->victim(shard, hash) : NULL;
+
+        // The new request is rejected unless it's more frequent than the victim
+        if (tmpNode == NULL || (admission && shard->admission && tiny_lfu_estimate(shard->admission, hash) <=
+            tiny_lfu_estimate(shard->admission, tmpNode->hash)))
+        {
+            admitted = false;
+            continue;
+        }
+
+        demotedCount = lru_evict_victim(cache, shard, tmpNode, diskTier, demoted, demotedCount);
+    }
+
+    if (admitted)
+    {
+        tmpNode = lru_alloc_node(shard);
+        shard->usedBytes += entrySize;
+        store_relaxed(tmpNode->hash, hash);
+        lru_node_set_request(shard, tmpNode, request, length);
+        lru_node_set_md5(cache_node_data(shard, tmpNode), md5);
+        lru_wheel_set_expiry(shard, tmpNode, expiry);
+        lru_hash_insert(shard, tmpNode, hash);
+        cache->policy->insert(shard, tmpNode, hash);
+        lru_node_write_seq(tmpNode);
+    }
+    pthread_mutex_unlock(&(shard->mutex));
+
+    lru_demote_victims(cache, diskTier, demoted, demotedCount);
+    if (admitted)
+        cache_stats_add(inserts, 1);
     else
+        cache_stats_add(rejections, 1);
+    return admitted;
+}
+
+// Evicts the expired elements of the ticks of the timing wheels elapsed since the last call
+void lru_cache_expire(lruCache_t *cache)
+{
+    lruCacheShard_t *shard;
+    uint32_t        index;
+    uint32_t        next;
+    uint64_t        now = lru_clock_ms();
+    uint64_t        tick = now / TTL_WHEEL_TICK_MS;
+
+    for (size_t i = 0; i < cache->shardNumber; i++)
     {
-	    tmpNode = cache->head->prev;
-        safe_free(tmpNode->request);
-        safe_free(tmpNode->md5);
-	    tmpNode->request = strdup(request);
-	    tmpNode->md5 = value;
+        shard = &(cache->shards[i]);
+
+        // Shards without any element to expire are skipped without taking their lock
+        if (!load_relaxed(shard->expiringCount))
+        {
+            shard->wheelTick = tick;
+            continue;
+        }
+
+        pthread_mutex_lock(&(shard->mutex));
+        epoch_enter();
+
+        // Only whole ticks are swept, and a full turn of the wheel covers every slot
+        if (tick - shard->wheelTick > TTL_WHEEL_SLOTS)
+            shard->wheelTick = tick - TTL_WHEEL_SLOTS;
+
+        for (; shard->wheelTick < tick; shard->wheelTick++)
+        {
+            // Nodes of later turns of the wheel share the slot and stay in it
+            for (index = shard->timingWheel[shard->wheelTick % TTL_WHEEL_SLOTS]; index != CACHE_NIL; index = next)
+            {
+                next = shard->nodeData[index].wheelNext;
+                if (shard->nodeData[index].expiry <= now)
+                {
+                    lru_evict_node(cache, shard, cache_node(shard, index));
+                    cache_stats_add(expirations, 1);
+                }
+            }
+        }
+
+        pthread_mutex_unlock(&(shard->mutex));
+        epoch_exit();
+    }
+}
+
+// Changes the capacity and the byte budget of the cache without flushing it
+size_t lru_cache_resize(lruCache_t *cache, size_t capacity, size_t bytes)
+{
+    lruCacheShard_t *shard;
+    size_t          shardNumber = cache->shardNumber;
+    size_t          shardCapacity;
+    size_t          total = 0;
+
+    // With a byte budget alone, the cache holds as many elements as fit in it
+    if (!capacity)
+        capacity = bytes / lru_entry_size(1);
+
+    // Split the new limits between the shards like lru_cache_init does, within their pools
+    for (size_t i = 0; i < shardNumber; i++)
+    {
+        shard = &(cache->shards[i]);
+        shardCapacity = capacity / shardNumber + (i < capacity % shardNumber);
+        if (shardCapacity > shard->poolCapacity)
+            shardCapacity = shard->poolCapacity;
+        else if (shardCapacity == 0)
+            shardCapacity = 1;
+
+        pthread_mutex_lock(&(shard->mutex));
+        shard->totalCapacity = shardCapacity;
+        shard->byteCapacity = bytes / shardNumber + (i < bytes % shardNumber);
+        pthread_mutex_unlock(&(shard->mutex));
+        total += shardCapacity;
+    }
+
+    cache->totalCapacity = total;
+    cache->totalBytes = bytes;
+    store_release(cache->shrinking, true);
+    return total;
+}
+
+// Evicts up to CACHE_EVICT_BATCH elements from each shard over its limits
+bool lru_cache_trim(lruCache_t *cache)
+{
+    lruCacheShard_t *shard;
+    diskTier_t      *diskTier = load_relaxed(cache->diskTier);
+    diskTierSlot_t  demoted[DISK_TIER_DEMOTE_BATCH];
+    size_t          demotedCount;
+    size_t          evicted;
+    bool            exceeds = true;
+    bool            pending = false;
+
+    // The flag is cleared before the pass, so a resize made during it is never missed
+    if (!__atomic_exchange_n(&(cache->shrinking), false, __ATOMIC_ACQ_REL))
+        return false;
+
+    for (size_t i = 0; i < cache->shardNumber; i++)
+    {
+        shard = &(cache->shards[i]);
+
+        // Victims are evicted in batches as big as the ones demoted after releasing the lock
+        for (evicted = 0, exceeds = true; exceeds && evicted < CACHE_EVICT_BATCH; )
+        {
+            pthread_mutex_lock(&(shard->mutex));
+            epoch_enter();
+            for (demotedCount = 0; evicted < CACHE_EVICT_BATCH && demotedCount < DISK_TIER_DEMOTE_BATCH &&
+                 (exceeds = lru_shard_exceeds(shard, 0, 0)); evicted++)
+                demotedCount = lru_evict_victim(cache, shard, cache->policy->victim(shard, 0), diskTier, demoted,
+                                                demotedCount);
+            exceeds = lru_shard_exceeds(shard, 0, 0);
+            pthread_mutex_unlock(&(shard->mutex));
+            epoch_exit();
+
+            lru_demote_victims(cache, diskTier, demoted, demotedCount);
+        }
+
+        pending |= exceeds;
     }
 
-    cache->head = tmpNode;
-    pthread_mutex_unlock(&(cache->mutex));
+    if (pending)
+        store_release(cache->shrinking, true);
+    return pending;
 }
@@ -0,0 +1,127 @@
+/*
+ * [meteoserver]
+ * nearCache.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Near cache of a thread of the pool, in front of the shared cache:
+ *   - A small direct-mapped table of the digests the thread has served lately. A hit only reads
+ *     memory of its own thread, so hot requests don't touch the shards of the shared cache.
+ *   - Every slot remembers the generation of the cache it was filled from. Flushing the cache
+ *     replaces it with one of a new generation, which invalidates the slots of every thread
+ *     without touching them.
+ *   - Slots keep the expiration of their element, and are only served until it expires.
+ *   - Every NEAR_CACHE_REFRESH hits, a slot lets the request through to the shared cache, so its
+ *     eviction policy still sees the requests served by the near caches.
+ */
+
+
+/**
+* @brief Allocs an empty near cache.
+* @return Near cache of a thread.
+*/
+nearCache_t *near_cache_init();
+
+/**
+* @brief Frees a near cache and the requests of its slots.
+* @param nearCache Near cache to be freed.
+*/
+void near_cache_free(nearCache_t *nearCache);
+
+/**
+* @brief Searches for a request in a near cache.
+* @param nearCache Near cache of the calling thread.
+* @param request Request to be searched.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param generation Generation of the current cache: slots filled from older ones are stale.
+* @param md5 Buffer where the digest is copied when found.
+* @return True if the request was found, hasn't expired and isn't due to be refreshed from the shared cache.
+*/
+bool near_cache_get(nearCache_t *nearCache, char *request, uint64_t hash, uint64_t generation, uint8_t *md5);
+
+/**
+* @brief Stores the digest of a request in a near cache, replacing whatever its slot held.
+* @param nearCache Near cache of the calling thread.
+* @param request Request to be stored.
+* @param hash Hash of the request, as computed by lru_hash_request.
+* @param generation Generation of the cache the digest was found in or inserted into.
+* @param md5 Digest of the request.
+* @param expiry Expiration of the element on the monotonic clock, 0 if it never expires.
+*/
+void near_cache_put(nearCache_t *nearCache, char *request, uint64_t hash, uint64_t generation, uint8_t *md5,
+                    uint64_t expiry);
+
+
+
+/* Definitions */
+
+
+// Allocs an empty near cache
+nearCache_t *near_cache_init()
+{
+    nearCache_t *nearCache = aligned_alloc(CACHE_LINE_SIZE, sizeof(nearCache_t));
+
+    if (nearCache)
+        memset(nearCache, 0, sizeof(nearCache_t));
+
+    return nearCache;
+}
+
+// Frees a near cache and the requests of its slots
+void near_cache_free(nearCache_t *nearCache)
+{
+    if (nearCache == NULL)
+        return;
+
+    for (size_t i = 0; i < NEAR_CACHE_SLOTS; i++)
+        safe_free(nearCache->slots[i].request);
+    free(nearCache);
+}
+
+// Searches for a request in a near cache
+bool near_cache_get(nearCache_t *nearCache, char *request, uint64_t hash, uint64_t generation, uint8_t *md5)
+{
+    nearCacheSlot_t *slot = &(nearCache->slots[hash & (NEAR_CACHE_SLOTS - 1)]);
+
+    if (slot->generation != generation || slot->hash != hash || !slot->request || strcmp(slot->request, request))
+        return false;
+
+    if ((slot->expiry && slot->expiry <= lru_clock_ms()) || ++slot->hits % NEAR_CACHE_REFRESH == 0)
+        return false;
+
+    memcpy(md5, slot->md5, MD5_DIGEST_SIZE);
+    return true;
+}
+
+// Stores the digest of a request in a near cache, replacing whatever its slot held
+void near_cache_put(nearCache_t *nearCache, char *request, uint64_t hash, uint64_t generation, uint8_t *md5,
+                    uint64_t expiry)
+{
+    nearCacheSlot_t *slot = &(nearCache->slots[hash & (NEAR_CACHE_SLOTS - 1)]);
+    size_t          size = strlen(request) + 1;
+
+    // The buffer of the slot is reused by any request that fits in it
+    if (size > slot->size)
+    {
+        safe_free(slot->request);
+        slot->request = malloc(size);
+        slot->size = size;
+    }
+
+    memcpy(slot->request, request, size);
+    memcpy(slot->md5, md5, MD5_DIGEST_SIZE);
+    slot->hash = hash;
+    slot->generation = generation;
+    slot->expiry = expiry;
+}
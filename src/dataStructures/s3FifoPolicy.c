@@ -0,0 +1,181 @@
+/*
+ * [meteoserver]
+ * s3FifoPolicy.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * S3-FIFO, applied to each shard independently:
+ *   - New requests enter a small FIFO queue (queue 0, a tenth of the shard), and the ones
+ *     found in the ghost queue go straight to the main FIFO queue (queue 1).
+ *   - A hit only increments the 2-bit frequency of its node, without taking any lock.
+ *   - The oldest node of the small queue is promoted to the main one if it was hit, and
+ *     evicted (leaving its hash in the ghost queue) if it wasn't. The oldest node of the
+ *     main queue is reinserted while its frequency, decremented on every pass, is not zero.
+ */
+
+
+/**
+* @brief Allocs the S3-FIFO state of a shard.
+* @param shard Shard to be initialized.
+*/
+static void s3fifo_policy_init(lruCacheShard_t *shard);
+
+/**
+* @brief Frees the S3-FIFO state of a shard.
+* @param shard Shard to be freed.
+*/
+static void s3fifo_policy_free(lruCacheShard_t *shard);
+
+/**
+* @brief Increments the frequency of a hit node, saturating at S3FIFO_MAX_FREQUENCY.
+* @param node Node that has been hit.
+*/
+static void s3fifo_policy_touch(lruCacheNode_t *node);
+
+/**
+* @brief Inserts a new node in the small queue, or in the main one when its request is a ghost.
+* @param shard Shard that contains the node.
+* @param node Node to be inserted.
+* @param hash Hash of the request of the node.
+*/
+static void s3fifo_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+/**
+* @brief Chooses the node to be evicted, promoting and reinserting the hit nodes on its way.
+* @param shard Shard whose node will be evicted.
+* @param hash Hash of the request that will replace the victim.
+* @return Node to be evicted.
+*/
+static lruCacheNode_t *s3fifo_policy_victim(lruCacheShard_t *shard, uint64_t hash);
+
+/**
+* @brief Unlinks an evicted node, leaving its hash in the ghost queue if it came from the small queue.
+* @param shard Shard that contains the node.
+* @param node Node to be evicted.
+* @param hash Hash of the request of the node.
+*/
+static void s3fifo_policy_remove(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash);
+
+
+
+/* Policy */
+
+
+const cachePolicy_t s3FifoPolicy = {
+    .name = "s3fifo",
+    .init = s3fifo_policy_init,
+    .free = s3fifo_policy_free,
+    .touch = s3fifo_policy_touch,
+    .hit = NULL,
+    .insert = s3fifo_policy_insert,
+    .victim = s3fifo_policy_victim,
+    .remove = s3fifo_policy_remove,
+    .next = cache_queue_next
+};
+
+
+
+/* Definitions */
+
+
+// Allocs the S3-FIFO state of a shard
+static void s3fifo_policy_init(lruCacheShard_t *shard)
+{
+    s3FifoState_t *s3fifo = calloc(1, sizeof(s3FifoState_t));
+
+    s3fifo->ghost = ghost_queue_init(shard->totalCapacity);
+    shard->policyData = s3fifo;
+}
+
+// Frees the S3-FIFO state of a shard
+static void s3fifo_policy_free(lruCacheShard_t *shard)
+{
+    s3FifoState_t *s3fifo = shard->policyData;
+
+    if (s3fifo)
+    {
+        ghost_queue_free(s3fifo->ghost);
+        safe_free(shard->policyData);
+    }
+}
+
+// Increments the frequency of a hit node, saturating at S3FIFO_MAX_FREQUENCY
+static void s3fifo_policy_touch(lruCacheNode_t *node)
+{
+    uint8_t frequency = load_relaxed(node->frequency);
+
+    // Concurrent hits may lose increments, which is fine for a 2-bit counter
+    if (frequency < S3FIFO_MAX_FREQUENCY)
+        store_relaxed(node->frequency, frequency + 1);
+}
+
+// Inserts a new node in the small queue, or in the main one when its request is a ghost
+static void s3fifo_policy_insert(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    s3FifoState_t *s3fifo = shard->policyData;
+
+    store_relaxed(node->frequency, 0);
+    cache_queue_push(shard, ghost_queue_remove(s3fifo->ghost, hash) ? 1 : 0, node);
+}
+
+// Chooses the node to be evicted, promoting and reinserting the hit nodes on its way
+static lruCacheNode_t *s3fifo_policy_victim(lruCacheShard_t *shard, uint64_t hash)
+{
+    size_t          smallCapacity = cache_policy_capacity(shard) / S3FIFO_SMALL_RATIO;
+    lruCacheNode_t  *node;
+    uint8_t         frequency;
+
+    (void)hash;
+    if (!smallCapacity)
+        smallCapacity = 1;
+
+    // Small queue: hit nodes are promoted to the main queue, the first cold one is the victim
+    while (shard->queues[0] && (shard->queueSizes[0] >= smallCapacity || !shard->queues[1]))
+    {
+        node = cache_queue_tail(shard, 0);
+        if (!load_relaxed(node->frequency))
+            return node;
+
+        cache_queue_unlink(shard, node);
+        store_relaxed(node->frequency, 0);
+        cache_queue_push(shard, 1, node);
+    }
+
+    // Main queue: hit nodes are reinserted with a lower frequency
+    while ((frequency = load_relaxed((node = cache_queue_tail(shard, 1))->frequency)))
+    {
+        cache_queue_unlink(shard, node);
+        store_relaxed(node->frequency, frequency - 1);
+        cache_queue_push(shard, 1, node);
+    }
+
+    return node;
+}
+
+// Unlinks an evicted node, leaving its hash in the ghost queue if it came from the small queue
+static void s3fifo_policy_remove(lruCacheShard_t *shard, lruCacheNode_t *node, uint64_t hash)
+{
+    s3FifoState_t *s3fifo = shard->policyData;
+
+    if (!node->next)
+        return;
+
+    if (node->queue == 0)
+        ghost_queue_push(s3fifo->ghost, hash);
+    cache_queue_unlink(shard, node);
+
+    // The ghost queue remembers as many requests as the shard holds
+    while (s3fifo->ghost->size > cache_policy_capacity(shard))
+        ghost_queue_pop(s3fifo->ghost);
+}
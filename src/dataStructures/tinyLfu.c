@@ -0,0 +1,243 @@
+/*
+ * [meteoserver]
+ * tinyLfu.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * TinyLFU frequency filter:
+ *   - A doorkeeper bloom filter absorbs the first occurrence of every request, so requests
+ *     seen only once never reach the sketch.
+ *   - A count-min sketch of 4-bit saturating counters estimates how often the rest appear.
+ *     Counters are packed two per byte, the even ones in the low nibble.
+ *   - Every 'sampleSize' additions all counters are halved and the doorkeeper is cleared,
+ *     so the estimations follow the recent popularity of the requests.
+ */
+
+
+/**
+* @brief Computes the index of a request in one of the rows of the sketch.
+* @param lfu Frequency filter.
+* @param hash Hash of the request.
+* @param row Row of the sketch.
+* @return Index of the counter.
+*/
+static size_t tiny_lfu_index(tinyLfu_t *lfu, uint64_t hash, unsigned int row);
+
+/**
+* @brief Reads a counter of the sketch.
+* @param lfu Frequency filter.
+* @param index Index of the counter.
+* @return Value of the counter.
+*/
+static unsigned int tiny_lfu_counter(tinyLfu_t *lfu, size_t index);
+
+/**
+* @brief Increments a counter of the sketch. It must be under TINYLFU_MAX_COUNT.
+* @param lfu Frequency filter.
+* @param index Index of the counter.
+*/
+static void tiny_lfu_counter_increment(tinyLfu_t *lfu, size_t index);
+
+/**
+* @brief Checks if a request is present in the doorkeeper, adding it if it wasn't.
+* @param lfu Frequency filter.
+* @param hash Hash of the request.
+* @return True if the request was already present.
+*/
+static bool tiny_lfu_doorkeeper_add(tinyLfu_t *lfu, uint64_t hash);
+
+/**
+* @brief Checks if a request is present in the doorkeeper.
+* @param lfu Frequency filter.
+* @param hash Hash of the request.
+* @return True if the request is present.
+*/
+static bool tiny_lfu_doorkeeper_contains(tinyLfu_t *lfu, uint64_t hash);
+
+/**
+* @brief Halves every counter of the sketch and clears the doorkeeper.
+* @param lfu Frequency filter to be aged.
+*/
+static void tiny_lfu_reset(tinyLfu_t *lfu);
+
+/**
+* @brief Allocs and initializes a frequency filter.
+* @param capacity Number of elements of the cache the filter is in front of.
+* @return Initialized frequency filter.
+*/
+tinyLfu_t *tiny_lfu_init(size_t capacity);
+
+/**
+* @brief Frees a frequency filter.
+* @param lfu Frequency filter to be freed.
+*/
+void tiny_lfu_free(tinyLfu_t *lfu);
+
+/**
+* @brief Records an occurrence of a request.
+* @param lfu Frequency filter.
+* @param hash Hash of the request.
+*/
+void tiny_lfu_increment(tinyLfu_t *lfu, uint64_t hash);
+
+/**
+* @brief Estimates how many times a request has been seen recently.
+* @param lfu Frequency filter.
+* @param hash Hash of the request.
+* @return Estimated frequency.
+*/
+unsigned int tiny_lfu_estimate(tinyLfu_t *lfu, uint64_t hash);
+
+
+
+/* Definitions */
+
+
+// Computes the index of a request in one of the rows of the sketch
+static size_t tiny_lfu_index(tinyLfu_t *lfu, uint64_t hash, unsigned int row)
+{
+    uint64_t step = ((hash >> 32) * 0x9e3779b97f4a7c15ULL) | 1;
+
+    return ((hash + row * step) & lfu->sketchMask) + row * (lfu->sketchMask + 1);
+}
+
+// Reads a counter of the sketch
+static unsigned int tiny_lfu_counter(tinyLfu_t *lfu, size_t index)
+{
+    return (lfu->sketch[index / 2] >> ((index & 1) * 4)) & TINYLFU_MAX_COUNT;
+}
+
+// Increments a counter of the sketch
+static void tiny_lfu_counter_increment(tinyLfu_t *lfu, size_t index)
+{
+    lfu->sketch[index / 2] += 1 << ((index & 1) * 4);
+}
+
+// Checks if a request is present in the doorkeeper, adding it if it wasn't
+static bool tiny_lfu_doorkeeper_add(tinyLfu_t *lfu, uint64_t hash)
+{
+    bool present = tiny_lfu_doorkeeper_contains(lfu, hash);
+
+    for (unsigned int i = 0; i < TINYLFU_DOORKEEPER_HASHES; i++)
+    {
+        size_t bit = (hash >> (i * 21)) & lfu->doorkeeperMask;
+        lfu->doorkeeper[bit / 64] |= 1ULL << (bit % 64);
+    }
+
+    return present;
+}
+
+// Checks if a request is present in the doorkeeper
+static bool tiny_lfu_doorkeeper_contains(tinyLfu_t *lfu, uint64_t hash)
+{
+    for (unsigned int i = 0; i < TINYLFU_DOORKEEPER_HASHES; i++)
+    {
+        size_t bit = (hash >> (i * 21)) & lfu->doorkeeperMask;
+        if (!(lfu->doorkeeper[bit / 64] & (1ULL << (bit % 64))))
+            return false;
+    }
+
+    return true;
+}
+
+// Halves every counter of the sketch and clears the doorkeeper
+static void tiny_lfu_reset(tinyLfu_t *lfu)
+{
+    // Both counters of a byte are halved at once, dropping the bit each one shifts into the other
+    for (size_t i = 0; i < (lfu->sketchMask + 1) * TINYLFU_SKETCH_ROWS / 2; i++)
+        lfu->sketch[i] = (lfu->sketch[i] >> 1) & 0x77;
+
+    memset(lfu->doorkeeper, 0, ((lfu->doorkeeperMask + 1) / 64) * sizeof(uint64_t));
+    lfu->additions /= 2;
+}
+
+// Allocs and initializes a frequency filter
+tinyLfu_t *tiny_lfu_init(size_t capacity)
+{
+    tinyLfu_t *lfu = calloc(1, sizeof(tinyLfu_t));
+
+    // One counter per element and row (half a byte each), and a doorkeeper with 8 bits per element
+    lfu->sketchMask = 64;
+    while (lfu->sketchMask < capacity)
+        lfu->sketchMask <<= 1;
+    lfu->doorkeeperMask = lfu->sketchMask * 8;
+
+    lfu->sketch = calloc(lfu->sketchMask * TINYLFU_SKETCH_ROWS / 2, sizeof(uint8_t));
+    lfu->doorkeeper = calloc(lfu->doorkeeperMask / 64, sizeof(uint64_t));
+    lfu->sketchMask--;
+    lfu->doorkeeperMask--;
+    lfu->sampleSize = capacity * TINYLFU_SAMPLE_FACTOR;
+    lfu->additions = 0;
+
+    return lfu;
+}
+
+// Frees a frequency filter
+void tiny_lfu_free(tinyLfu_t *lfu)
+{
+    if (lfu)
+    {
+        safe_free(lfu->sketch);
+        safe_free(lfu->doorkeeper);
+        safe_free(lfu);
+    }
+}
+
+// Records an occurrence of a request
+void tiny_lfu_increment(tinyLfu_t *lfu, uint64_t hash)
+{
+    unsigned int    minimum = TINYLFU_MAX_COUNT;
+    size_t          index;
+
+    // The first occurrence only reaches the doorkeeper
+    if (tiny_lfu_doorkeeper_add(lfu, hash))
+    {
+        for (unsigned int i = 0; i < TINYLFU_SKETCH_ROWS; i++)
+        {
+            index = tiny_lfu_index(lfu, hash, i);
+            if (tiny_lfu_counter(lfu, index) < minimum)
+                minimum = tiny_lfu_counter(lfu, index);
+        }
+
+        // Conservative update: only the counters holding the estimation are incremented
+        for (unsigned int i = 0; i < TINYLFU_SKETCH_ROWS && minimum < TINYLFU_MAX_COUNT; i++)
+        {
+            index = tiny_lfu_index(lfu, hash, i);
+            if (tiny_lfu_counter(lfu, index) == minimum)
+                tiny_lfu_counter_increment(lfu, index);
+        }
+    }
+
+    if (++lfu->additions >= lfu->sampleSize)
+        tiny_lfu_reset(lfu);
+}
+
+// Estimates how many times a request has been seen recently
+unsigned int tiny_lfu_estimate(tinyLfu_t *lfu, uint64_t hash)
+{
+    unsigned int    minimum = TINYLFU_MAX_COUNT;
+    size_t          index;
+
+    if (!tiny_lfu_doorkeeper_contains(lfu, hash))
+        return 0;
+
+    for (unsigned int i = 0; i < TINYLFU_SKETCH_ROWS; i++)
+    {
+        index = tiny_lfu_index(lfu, hash, i);
+        if (tiny_lfu_counter(lfu, index) < minimum)
+            minimum = tiny_lfu_counter(lfu, index);
+    }
+
+    return minimum + 1;
+}
@@ -24,6 +24,29 @@ volatile sig_atomic_t serverHandler = SERVER_ENABLED;
 */
 static void print_help_message(char **argv);
 
+/**
+* @brief Parses an amount of bytes, with an optional K, M or G suffix.
+* @param str String containing the amount.
+* @return Amount of bytes, 0 if the string isn't valid.
+*/
+static size_t parse_bytes(char *str);
+
+/**
+* @brief Reads the settings of the cache from a configuration file, with one 'option value' pair per line.
+*        Only the options that can be changed at runtime are accepted: 'cache-size' and 'cache-bytes'.
+* @param args Struct where the settings found in the file are stored.
+* @param path Path of the configuration file.
+* @return True if the whole file is valid.
+*/
+static bool parse_config_file(arguments_t *args, char *path);
+
+/**
+* @brief Checks that the cache has a valid size, deriving it from the byte budget when it wasn't given.
+* @param args Struct that holds the settings of the cache.
+* @return True if the cache has a valid size.
+*/
+static bool settle_cache_size(arguments_t *args);
+
 /**
 * @brief In charge of parsing the in-line arguments.
 * @param args Struct that'll hold all the relevant information from the in-line arguments.
@@ -47,12 +70,57 @@ static void initialize_server_data(serverState_t **state, int argc, char **argv)
 */
 static void teardown_server(serverState_t   *state);
 
+/**
+* @brief Writes the elements restored from the snapshot and the insert log to the standard output, and
+*        releases all the server's resources, without ever serving a request.
+* @param state Struct that contains information from the program current state.
+* @return Error/success code, to be returned by the program.
+*/
+static int  dump_offline(serverState_t *state);
+
 /**
 * @brief In charge of freeing the program's currently allocated resources.
 * @param state General struct that contains information from the program current state.
 */
 static void free_current_data(serverState_t   *state);
 
+/**
+* @brief Function in charge of resizing the cache to the settings of the configuration file, after receiving a HUP signal.
+* @param state General struct that contains information from the program current state.
+*/
+static void reload_configuration(serverState_t *state);
+
+/**
+* @brief Saves a snapshot of the cache, compacting the insert log into it: the log is truncated once the
+*        snapshot holds every element it recorded.
+* @param state General struct that contains information from the program current state.
+* @return True if the snapshot was saved.
+*/
+static bool save_snapshot(serverState_t *state);
+
+/**
+* @brief Returns the size the insert log can reach before it's compacted again: twice the size of the
+*        snapshot it's compacted into, so compacting takes a fraction of the time spent appending.
+* @param state General struct that contains information from the program current state.
+* @return Size of the insert log that triggers its compaction.
+*/
+static size_t compaction_threshold(serverState_t *state);
+
+/**
+* @brief Function in charge of evicting the expired elements of the cache, one tick of its timing wheels at a time,
+*        and the elements over its capacity after it's been shrunk.
+* @param state General struct that contains information from the program current state.
+*/
+static void *cache_sweeper(void *state);
+
+/**
+* @brief Function in charge of saving a snapshot of the cache after receiving a USR2 signal or when the insert log
+*        grows too much, and of replacing the cache after receiving a USR1 signal, freeing the old one once no
+*        thread of the pool can be using it.
+* @param state General struct that contains information from the program current state.
+*/
+static void *cache_maintainer(void *state);
+
 /**
 * @brief Function in charge of:
 *   - Initializing the thread pool, in charge of monitoring and processing client requests.
@@ -69,21 +137,133 @@ static void start_server(serverState_t *state);
 static void print_help_message(char **argv)
 {
     printf("\n");
-    printf("Usage: %s [-p port] [-C amount] [-t amount]\n", argv[0]);
+    printf("Usage: %s [-p port] [-C amount] [-t amount] [-S amount] [-E policy] [-A] [-T seconds] [-B bytes] [-f file] [-s file] [-l file]\n"
+           "       [--disk-tier file --disk-tier-bytes bytes] [--huge-pages] [--warm file] [--dump]\n",
+           argv[0]);
     printf("    -p  <port>          Port.\n");
-    printf("    -C  <amount>        Cache size.\n");
+    printf("    -C, --cache-size <amount>\n");
+    printf("                        Cache size.\n");
+    printf("    -B, --cache-bytes <bytes>\n");
+    printf("                        Memory budget of the cache, with an optional K, M or G suffix.\n");
+    printf("    -f, --config <file> Configuration file with the cache size and budget, read again on SIGHUP.\n");
+    printf("    -s, --snapshot <file>\n");
+    printf("                        Snapshot file of the cache, restored on startup and saved on SIGUSR2 and exit.\n");
+    printf("    -l, --log <file>    Log of the inserted elements, replayed on startup and compacted into the snapshot.\n");
+    printf("    --disk-tier <file>  File of the second tier of the cache, where the evicted elements are demoted.\n");
+    printf("    --disk-tier-bytes <bytes>\n");
+    printf("                        Size of the disk tier, with an optional K, M or G suffix.\n");
+    printf("    --warm <file>       File with one key per line, whose digests are cached before listening.\n");
+    printf("    --huge-pages        Back the cache with huge pages, reserved ones if available or transparent ones.\n");
+    printf("    --dump              Print the elements of the snapshot and the insert log, and exit without serving.\n");
     printf("    -t  <amount>        Number of threads used as thread pool (8 by default).\n");
+    printf("    -S  <amount>        Number of cache shards (16 by default, at least 64 elements per shard).\n");
+    printf("    -E, --policy <lru|clock|arc|s3fifo>\n");
+    printf("                        Eviction policy of the cache (lru by default).\n");
+    printf("    -A                  Enable the TinyLFU admission filter of the cache.\n");
+    printf("    -T, --ttl <seconds> Default time to live of the cached elements (no expiration by default).\n");
     printf("    -h                  Show this help message.\n");
     printf("\n");
 }
 
+// Parses an amount of bytes, with an optional K, M or G suffix
+static size_t parse_bytes(char *str)
+{
+    char    *end;
+    size_t  bytes = strtoull(str, &end, 10);
+
+    switch (*end)
+    {
+        case 'G': case 'g':
+            bytes *= 1024;
+            /* fall through */
+        case 'M': case 'm':
+            bytes *= 1024;
+            /* fall through */
+        case 'K': case 'k':
+            bytes *= 1024;
+            end++;
+            break;
+    }
+
+    return *end || end == str ? 0 : bytes;
+}
+
+// Reads the settings of the cache from a configuration file
+static bool parse_config_file(arguments_t *args, char *path)
+{
+    FILE    *file;
+    char    line[256];
+    char    *option;
+    char    *value;
+    char    *savePtr;
+    bool    valid = true;
+
+    if ((file = fopen(path, "r")) == NULL)
+    {
+        fprintf(stderr, "Error: Can't open the configuration file '%s'.\n", path);
+        return false;
+    }
+
+    while (valid && fgets(line, sizeof(line), file))
+    {
+        // Empty lines and comments are skipped
+        if ((option = strtok_r(line, " \t\r\n", &savePtr)) == NULL || *option == '#')
+            continue;
+        value = strtok_r(NULL, " \t\r\n", &savePtr);
+
+        if (value && !strcmp(option, "cache-size"))
+            valid = (args->cacheSize = atoi(value)) > 0;
+        else if (value && !strcmp(option, "cache-bytes"))
+            valid = (args->cacheBytes = parse_bytes(value)) > 0;
+        else
+            valid = false;
+
+        if (valid == false)
+            fprintf(stderr, "Error: Invalid line '%s%s%s' in the configuration file.\n", option, value ? " " : "",
+                    value ? value : "");
+    }
+
+    fclose(file);
+    return valid;
+}
+
+// Checks that the cache has a valid size, deriving it from the byte budget when it wasn't given
+static bool settle_cache_size(arguments_t *args)
+{
+    // With a byte budget alone, the cache holds as many elements as fit in it
+    args->sizeFromBudget = args->cacheSize <= 0 && args->cacheBytes > 0;
+    if (args->sizeFromBudget)
+    {
+        args->cacheSize = INT_MAX;
+        if (args->cacheBytes / lru_entry_size(1) < INT_MAX)
+            args->cacheSize = args->cacheBytes / lru_entry_size(1);
+    }
+
+    return args->cacheSize > 0;
+}
+
 // In charge of parsing the in-line arguments
 static bool parse_arguments(arguments_t *args, int argc, char **argv)
 {
-    const char  *short_opt = "p:C:ht:";
-    int         c;
-
-    while ((c = getopt(argc, argv, short_opt)) != -1)
+    const char          *short_opt = "p:C:ht:S:E:AT:B:f:s:l:";
+    const struct option long_opt[] = {
+        {"cache-size", required_argument, NULL, 'C'},
+        {"config", required_argument, NULL, 'f'},
+        {"snapshot", required_argument, NULL, 's'},
+        {"log", required_argument, NULL, 'l'},
+        {"disk-tier", required_argument, NULL, 'D'},
+        {"disk-tier-bytes", required_argument, NULL, 'K'},
+        {"policy", required_argument, NULL, 'E'},
+        {"ttl", required_argument, NULL, 'T'},
+        {"cache-bytes", required_argument, NULL, 'B'},
+        {"huge-pages", no_argument, NULL, 'H'},
+        {"warm", required_argument, NULL, 'W'},
+        {"dump", no_argument, NULL, 'd'},
+        {NULL, 0, NULL, 0}
+    };
+    int                 c;
+
+    while ((c = getopt_long(argc, argv, short_opt, long_opt, NULL)) != -1)
     {
         switch (c)
         {
@@ -96,33 +276,126 @@ static bool parse_arguments(arguments_t *args, int argc, char **argv)
             case 't':
                 args->threadNumber = atoi(optarg);
                 break;
+            case 'S':
+                args->shardNumber = atoi(optarg);
+                break;
+            case 'E':
+                if ((args->policy = cache_policy_find(optarg)) == NULL)
+                {
+                    fprintf(stderr, "Error: Unknown eviction policy '%s'.\n", optarg);
+                    return false;
+                }
+                break;
+            case 'A':
+                args->admission = true;
+                break;
+            case 'T':
+                args->ttl = strtoul(optarg, NULL, 10);
+                break;
+            case 'B':
+                if ((args->cacheBytes = parse_bytes(optarg)) == 0)
+                {
+                    fprintf(stderr, "Error: Invalid cache budget '%s'.\n", optarg);
+                    return false;
+                }
+                break;
+            case 'f':
+                args->configFile = optarg;
+                break;
+            case 's':
+                args->snapshotFile = optarg;
+                break;
+            case 'l':
+                args->logFile = optarg;
+                break;
+            case 'D':
+                args->diskTierFile = optarg;
+                break;
+            case 'H':
+                args->hugePages = true;
+                break;
+            case 'W':
+                args->warmFile = optarg;
+                break;
+            case 'd':
+                args->dumpOnly = true;
+                break;
+            case 'K':
+                if ((args->diskTierBytes = parse_bytes(optarg)) == 0)
+                {
+                    fprintf(stderr, "Error: Invalid disk tier size '%s'.\n", optarg);
+                    return false;
+                }
+                break;
             default:
                 print_help_message(argv);
                 return false;
         }
     }
 
-    if (args->port <= 0)
+    // The offline dump never binds the port
+    if (args->port <= 0 && args->dumpOnly == false)
     {
         fprintf(stderr, "Error: A valid '-p' (port) argument is obligatory.\n");
         return false;
     }
 
-    if (args->cacheSize <= 0)
+    if (args->logFile && args->snapshotFile == NULL)
+    {
+        fprintf(stderr, "Error: The insert log ('-l') needs a snapshot file ('-s') to be compacted into.\n");
+        return false;
+    }
+
+    if (args->dumpOnly && args->snapshotFile == NULL)
+    {
+        fprintf(stderr, "Error: The offline dump ('--dump') needs a snapshot file ('-s') to be read.\n");
+        return false;
+    }
+
+    if ((args->diskTierFile == NULL) != (args->diskTierBytes == 0))
+    {
+        fprintf(stderr, "Error: The disk tier needs both '--disk-tier' and '--disk-tier-bytes'.\n");
+        return false;
+    }
+
+    // The settings of the configuration file take precedence over the in-line ones
+    if (args->configFile && parse_config_file(args, args->configFile) == false)
+        return false;
+
+    if (settle_cache_size(args) == false)
     {
-        fprintf(stderr, "Error: A valid '-C' (cache size) argument is obligatory.\n");
+        fprintf(stderr, "Error: A valid '-C' (cache size) or '-B' (cache budget) argument is obligatory.\n");
         return false;
     }
 
     if (args->threadNumber <= 0 || args->threadNumber >= 1000)
         args->threadNumber = THREAD_POOL_SIZE;
 
+    if (args->policy == NULL)
+        args->policy = &lruPolicy;
+
+    // By default, avoid shards so small that they stop behaving like an LRU
+    if (args->shardNumber <= 0)
+    {
+        args->shardNumber = args->cacheSize / CACHE_MIN_SHARD_SIZE;
+        if (args->shardNumber > CACHE_SHARD_NUMBER)
+            args->shardNumber = CACHE_SHARD_NUMBER;
+        else if (args->shardNumber == 0)
+            args->shardNumber = 1;
+    }
+
     return true;
 }
 
 // In charge of initializing all the data structures needed to start the server
 static void initialize_server_data(serverState_t **state, int argc, char **argv)
 {
+    size_t   restored;
+    size_t   replayed;
+    size_t   warmed;
+    uint64_t start;
+    FILE     *status;
+
     *state = calloc(1, sizeof(serverState_t));
 
     if (*state == NULL)
@@ -136,22 +409,73 @@ static void initialize_server_data(serverState_t **state, int argc, char **argv)
     }
 
     // Initialize the required data structures
-    (*state)->lruCache = lru_cache_init((*state)->settings.cacheSize);
+    (*state)->lruCache = lru_cache_init(&(*state)->settings);
+    (*state)->startTime = lru_clock_ms();
+    (*state)->inflightTable = inflight_table_init();
+    (*state)->heavyHitters = heavy_hitters_init();
     (*state)->requestQueue = linked_queue_init();
     (*state)->thread_pool = calloc((*state)->settings.threadNumber, sizeof(pthread_t));
+    if ((*state)->settings.diskTierFile)
+        (*state)->diskTier = disk_tier_open((*state)->settings.diskTierFile, (*state)->settings.diskTierBytes);
 
     // Error handling
-    if ((*state)->lruCache == NULL || (*state)->requestQueue == NULL || (*state)->thread_pool == NULL)
+    if ((*state)->lruCache == NULL || (*state)->inflightTable == NULL || (*state)->heavyHitters == NULL ||
+        (*state)->requestQueue == NULL || (*state)->thread_pool == NULL ||
+        ((*state)->settings.diskTierFile && (*state)->diskTier == NULL))
     {
         free_current_data(*state);
         exit(ERROR);
     }
+    (*state)->lruCache->diskTier = (*state)->diskTier;
+
+    // The offline dump keeps the standard output for the elements
+    status = (*state)->settings.dumpOnly ? stderr : stdout;
+    if ((*state)->settings.hugePages)
+        fprintf(status, "Huge pages: %s.\n", lru_cache_page_backing((*state)->lruCache));
+
+    // Warm up the cache with the last snapshot. A damaged one is only partially restored
+    if ((*state)->settings.snapshotFile)
+    {
+        if (cache_snapshot_load((*state)->lruCache, (*state)->settings.snapshotFile, &restored) == false)
+            fprintf(stderr, "Error: The snapshot '%s' is not valid.\n", (*state)->settings.snapshotFile);
+        fprintf(status, "Loaded %zu elements from '%s'.\n", restored, (*state)->settings.snapshotFile);
+    }
+
+    // The elements inserted since the snapshot was saved are replayed on top of it
+    if ((*state)->settings.logFile)
+    {
+        (*state)->insertLog = insert_log_open((*state)->settings.logFile, (*state)->lruCache, &replayed);
+        if ((*state)->insertLog == NULL)
+        {
+            free_current_data(*state);
+            exit(ERROR);
+        }
+        fprintf(status, "Replayed %zu elements from '%s'.\n", replayed, (*state)->settings.logFile);
+    }
+
+    // The listed keys are cached before the server starts listening, by as many threads as the pool has
+    if ((*state)->settings.warmFile)
+    {
+        start = lru_clock_ms();
+        if (cache_warm((*state)->lruCache, (*state)->settings.warmFile, (*state)->settings.threadNumber,
+                       &warmed) == false)
+        {
+            free_current_data(*state);
+            exit(ERROR);
+        }
+        fprintf(status, "Warmed %zu elements from '%s' in %.2f seconds.\n", warmed, (*state)->settings.warmFile,
+                (lru_clock_ms() - start) / 1000.0);
+    }
 }
 
 // In charge of freeing resources before the program finishes its execution
 static void free_current_data(serverState_t   *state)
 {
+    insert_log_close(state->insertLog);
     lru_cache_free(state->lruCache);
+    disk_tier_close(state->diskTier);
+    inflight_table_free(state->inflightTable);
+    heavy_hitters_free(state->heavyHitters);
     linked_queue_free(state->requestQueue);
     safe_free(state->thread_pool);
     safe_free(state->lruCache);
@@ -167,41 +491,239 @@ static void teardown_server(serverState_t   *state)
     // Wait for all the threads to finish their execution
     for (int i = 0; i < state->settings.threadNumber; i++)
         pthread_join(state->thread_pool[i], NULL);
+    pthread_join(state->sweeper, NULL);
+
+    // Release the maintainer, which may be waiting for a flush or a snapshot
+    pthread_mutex_lock(&(state->cacheMutex));
+    pthread_cond_broadcast(&(state->maintenanceRequested));
+    pthread_mutex_unlock(&(state->cacheMutex));
+    pthread_join(state->maintainer, NULL);
+
+    // Print each one of the cached elements, and save them for the next start
+    fflush(stdout);
+    cache_dump(&(state->lruCache), STDOUT_FILENO);
+    if (state->settings.snapshotFile)
+        save_snapshot(state);
 
-    // Print each one of the cached elements
-    for (size_t i = 0; i < state->lruCache->currentCapacity; i++)
-    {
-        printf("Request: '%s' with hash: '%s'\n", state->lruCache->head->request,
-                state->lruCache->head->md5);
-        state->lruCache->head = state->lruCache->head->next;
-    }
-    
     close(state->serverSocket);
     free_current_data(state);
+    epoch_free_all();
     printf("Bye!\n");
 }
 
+// Writes the elements restored from the snapshot and the insert log to the standard output
+static int  dump_offline(serverState_t *state)
+{
+    bool dumped = cache_dump(&(state->lruCache), STDOUT_FILENO);
+
+    free_current_data(state);
+    epoch_free_all();
+    return dumped ? SUCCESS : ERROR;
+}
+
+// Function in charge of resizing the cache to the settings of the configuration file
+static void reload_configuration(serverState_t *state)
+{
+    arguments_t settings = state->settings;
+    size_t      capacity;
+
+    serverHandler &= ~(SERVER_SIGHUP);
+    if (settings.configFile == NULL)
+    {
+        fprintf(stderr, "Error: There's no configuration file to reload.\n");
+        return;
+    }
+
+    // A size derived from the old budget is derived again from the new one
+    if (settings.sizeFromBudget)
+        settings.cacheSize = 0;
+    if (parse_config_file(&settings, settings.configFile) == false || settle_cache_size(&settings) == false)
+        return;
+
+    // The settings and the cache they're applied to can't be replaced meanwhile by a flush.
+    // The cache is shrunk in the background by the sweeper
+    pthread_mutex_lock(&(state->cacheMutex));
+    capacity = lru_cache_resize(state->lruCache, settings.sizeFromBudget ? 0 : settings.cacheSize,
+                                settings.cacheBytes);
+    state->settings.cacheSize = settings.cacheSize;
+    state->settings.cacheBytes = settings.cacheBytes;
+    state->settings.sizeFromBudget = settings.sizeFromBudget;
+    pthread_mutex_unlock(&(state->cacheMutex));
+    printf("Resized to %zu elements.\n", capacity);
+}
+
+// Saves a snapshot of the cache, compacting the insert log into it
+static bool save_snapshot(serverState_t *state)
+{
+    bool saved;
+
+    // The records appended while the snapshot is saved wait in memory, so truncating the log loses none of them.
+    // Only this thread replaces the cache, and the records of the ones it replaced are left out
+    if (state->insertLog)
+        insert_log_pause(state->insertLog, state->lruCache->generation);
+    saved = cache_snapshot_save(state->lruCache, state->settings.snapshotFile);
+    if (state->insertLog)
+        insert_log_resume(state->insertLog, saved);
+
+    return saved;
+}
+
+// Returns the size the insert log can reach before it's compacted again
+static size_t compaction_threshold(serverState_t *state)
+{
+    struct stat info;
+
+    if (stat(state->settings.snapshotFile, &info) < 0 || (size_t)info.st_size * 2 < INSERT_LOG_COMPACT_BYTES)
+        return INSERT_LOG_COMPACT_BYTES;
+    return (size_t)info.st_size * 2;
+}
+
+// Function in charge of evicting the expired elements of the cache
+static void *cache_sweeper(void *state)
+{
+    serverState_t   *serverState = (serverState_t *)state;
+    lruCache_t      *cache;
+    bool            trimming = false;
+
+    while (serverHandler & SERVER_ENABLED)
+    {
+        // While the cache is being shrunk, it's trimmed in batches without waiting for the next tick
+        if (trimming == false)
+            usleep(TTL_WHEEL_TICK_MS * 1000);
+
+        // The cache is pinned while it's swept, since a flush can replace it at any time
+        epoch_enter();
+        cache = load_acquire(serverState->lruCache);
+        lru_cache_expire(cache);
+        trimming = lru_cache_trim(cache);
+        epoch_exit();
+    }
+
+    pthread_exit(NULL);
+}
+
+// Function in charge of saving snapshots of the cache and of replacing it
+static void *cache_maintainer(void *state)
+{
+    serverState_t   *serverState = (serverState_t *)state;
+    insertLog_t     *log = serverState->insertLog;
+    lruCache_t      *cache;
+    struct timespec deadline;
+    size_t          compactAt = log ? compaction_threshold(serverState) : 0;
+    bool            compact;
+    bool            requested;
+
+    pthread_mutex_lock(&(serverState->cacheMutex));
+    while (serverHandler & SERVER_ENABLED)
+    {
+        compact = log && insert_log_size(log) >= compactAt;
+        if (serverState->flushPending == false && serverState->snapshotPending == false && compact == false)
+        {
+            // The size of the insert log is checked periodically
+            if (log == NULL)
+                pthread_cond_wait(&(serverState->maintenanceRequested), &(serverState->cacheMutex));
+            else
+            {
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += INSERT_LOG_CHECK_MS / 1000;
+                pthread_cond_timedwait(&(serverState->maintenanceRequested), &(serverState->cacheMutex), &deadline);
+            }
+            continue;
+        }
+
+        // Only this thread replaces the cache, so it can't be freed while it's saved
+        if (serverState->snapshotPending || compact)
+        {
+            requested = serverState->snapshotPending;
+            serverState->snapshotPending = false;
+            pthread_mutex_unlock(&(serverState->cacheMutex));
+
+            if (serverState->settings.snapshotFile == NULL)
+                fprintf(stderr, "Error: There's no snapshot file to save the cache to.\n");
+            else if (save_snapshot(serverState) && requested)
+                printf("Saved!\n");
+            if (log)
+                compactAt = compaction_threshold(serverState);
+
+            pthread_mutex_lock(&(serverState->cacheMutex));
+            continue;
+        }
+        serverState->flushPending = false;
+
+        // The threads of the pool only see one cache or the other, each of them in a single
+        // epoch, so the old one is freed once every thread pinned before the swap has finished
+        if ((cache = lru_cache_init(&(serverState->settings))) == NULL)
+        {
+            fprintf(stderr, "Error: Can't allocate the flushed cache.\n");
+            continue;
+        }
+        cache->diskTier = serverState->diskTier;
+        cache = __atomic_exchange_n(&(serverState->lruCache), cache, __ATOMIC_ACQ_REL);
+        pthread_mutex_unlock(&(serverState->cacheMutex));
+
+        // The flushed elements are dropped from the insert log as well, by compacting it into the empty cache
+        if (log)
+            save_snapshot(serverState);
+
+        // The disk tier is emptied too, and the old cache stops demoting its victims to it. The
+        // ones it already evicted are dropped by the tier, which only takes those of the new cache
+        if (serverState->diskTier)
+        {
+            store_relaxed(cache->diskTier, NULL);
+            disk_tier_clear(serverState->diskTier, serverState->lruCache->generation);
+        }
+
+        epoch_synchronize();
+        lru_cache_free(cache);
+        safe_free(cache);
+        printf("Done!\n");
+
+        pthread_mutex_lock(&(serverState->cacheMutex));
+    }
+    pthread_mutex_unlock(&(serverState->cacheMutex));
+
+    pthread_exit(NULL);
+}
+
 // In charge of running the two main sections of the server
 static void start_server(serverState_t *state)
 {
     int connection;
+    int *clientSocket;
 
     // Initialize thread pool in charge of processing client requests
     pthread_mutex_init(&(state->queueMutex), NULL);
     for (int i = 0; i < state->settings.threadNumber; i++)
         pthread_create(&(state->thread_pool[i]), NULL, request_monitor, state);
 
+    // Initialize the threads in charge of expiring the cached elements, and of saving and replacing the cache
+    pthread_mutex_init(&(state->cacheMutex), NULL);
+    pthread_cond_init(&(state->maintenanceRequested), NULL);
+    state->flushPending = false;
+    state->snapshotPending = false;
+    pthread_create(&(state->sweeper), NULL, cache_sweeper, state);
+    pthread_create(&(state->maintainer), NULL, cache_maintainer, state);
+
     // Main loop in charge of accepting connections
     while (serverHandler & SERVER_ENABLED)
     {    
         if (serverHandler & SERVER_SIGUSR1)
             empty_cache(state);
 
+        if (serverHandler & SERVER_SIGHUP)
+            reload_configuration(state);
+
+        if (serverHandler & SERVER_SIGUSR2)
+            snapshot_cache(state);
+
         if ((connection = accept(state->serverSocket, NULL, NULL)) < 0)
             continue;
 
-        // Add connection to the thread-safe linked queue
-        linked_queue_push_ex(state->requestQueue, &connection);
+        // Add connection to the thread-safe linked queue. Each one gets its own copy,
+        // released by the thread that processes it
+        clientSocket = malloc(sizeof(int));
+        *clientSocket = connection;
+        linked_queue_push_ex(state->requestQueue, clientSocket);
     }
 }
 
@@ -217,6 +739,8 @@ int main(int argc, char **argv)
 
     // Parse arguments and initialize the server main data structures
     initialize_server_data(&state, argc, argv);
+    if (state->settings.dumpOnly)
+        return dump_offline(state);
 
     // Setup socket, bind and listen functions
     setup_server_networking(state);
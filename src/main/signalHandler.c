@@ -26,7 +26,15 @@ void signal_modifier();
 static void signal_handler(int signal);
 
 /**
-* @brief Function in charge of freeing the cache after receiving a USR1 signal.
+* @brief Function in charge of requesting a snapshot of the cache after receiving a USR2 signal. The snapshot
+*        is saved by the maintainer thread.
+* @param state General struct that contains information from the program current state.
+*/
+void snapshot_cache(serverState_t *state);
+
+/**
+* @brief Function in charge of requesting a new cache after receiving a USR1 signal. The cache is replaced and
+*        the old one freed by the maintainer thread.
 * @param state General struct that contains information from the program current state.
 */
 void empty_cache(serverState_t *state);
@@ -36,15 +44,27 @@ void empty_cache(serverState_t *state);
 /* Definitions */
 
 
-// Function in charge of freeing the cache after receiving a USR1 signal
+// Function in charge of requesting a new cache after receiving a USR1 signal
 void empty_cache(serverState_t *state)
 {
     serverHandler &= ~(SERVER_SIGUSR1); 
 
-    lru_cache_free(state->lruCache);
-    safe_free(state->lruCache);
-    state->lruCache = lru_cache_init(state->settings.cacheSize);
-    printf("Done!\n");
+    // Accepting connections never waits for the cache to be replaced nor freed
+    pthread_mutex_lock(&(state->cacheMutex));
+    state->flushPending = true;
+    pthread_cond_signal(&(state->maintenanceRequested));
+    pthread_mutex_unlock(&(state->cacheMutex));
+}
+
+// Function in charge of requesting a snapshot of the cache after receiving a USR2 signal
+void snapshot_cache(serverState_t *state)
+{
+    serverHandler &= ~(SERVER_SIGUSR2);
+
+    pthread_mutex_lock(&(state->cacheMutex));
+    state->snapshotPending = true;
+    pthread_cond_signal(&(state->maintenanceRequested));
+    pthread_mutex_unlock(&(state->cacheMutex));
 }
 
 // Wrapper function that sets up the structures needed to modify signal behavior
@@ -56,6 +76,8 @@ void signal_modifier()
     handler.sa_flags = 0;
 
     sigaction(SIGUSR1, &handler, NULL);
+    sigaction(SIGHUP, &handler, NULL);
+    sigaction(SIGUSR2, &handler, NULL);
     sigaction(SIGTERM, &handler, NULL);
     sigaction(SIGINT, &handler, NULL);
 }
@@ -67,6 +89,14 @@ static void signal_handler(int signal)
     {
         serverHandler |= SERVER_SIGUSR1;
     }
+    else if (signal == SIGHUP)
+    {
+        serverHandler |= SERVER_SIGHUP;
+    }
+    else if (signal == SIGUSR2)
+    {
+        serverHandler |= SERVER_SIGUSR2;
+    }
     else if (signal == SIGTERM || signal == SIGINT)
     {
         serverHandler &= ~(SERVER_ENABLED);
@@ -30,13 +30,62 @@ static int  tokenize_request(char *str, request_t *request);
 */
 static bool read_client_request(request_t *request, int *connection);
 
+/**
+* @brief Searches for a request in the near cache of the thread, then in the current cache, and in the disk tier
+*        when it misses.
+* @param serverState Data structure containing the global server information.
+* @param nearCache Near cache of the calling thread.
+* @param request Data structure that holds the data from the request.
+* @param md5 Buffer where the cached digest is copied.
+* @param repeated Whether the request has already missed once, so it isn't counted again in the statistics.
+* @return True if the request is cached.
+*/
+static bool cache_lookup(serverState_t *serverState, nearCache_t *nearCache, request_t *request, uint8_t *md5,
+                         bool repeated);
+
+/**
+* @brief Inserts a request and its digest in the current cache and, if the cache took it, in the near cache of
+*        the thread and in the insert log.
+* @param serverState Data structure containing the global server information.
+* @param nearCache Near cache of the calling thread.
+* @param request Data structure that holds the data from the request.
+* @param md5 Digest of the request.
+*/
+static void cache_insert(serverState_t *serverState, nearCache_t *nearCache, request_t *request, uint8_t *md5);
+
+/**
+* @brief Sends the statistics of the cache to a client: its counters, added up from every thread, and
+*        the ratios derived from them.
+* @param connection Client socket.
+* @param serverState Data structure containing the global server information.
+*/
+static void send_cache_stats(int connection, serverState_t *serverState);
+
+/**
+* @brief Sends the most requested keys to a client, one per line with its estimated count and the
+*        possible overestimation of the count.
+* @param connection Client socket.
+* @param serverState Data structure containing the global server information.
+* @param k Maximum number of keys to be sent.
+*/
+static void send_heavy_hitters(int connection, serverState_t *serverState, size_t k);
+
+/**
+* @brief Streams every cached element to a client, one per line with its digest.
+* @param connection Client socket.
+* @param serverState Data structure containing the global server information.
+*/
+static void send_cache_dump(int connection, serverState_t *serverState);
+
 /**
 * @brief Function in charge of processing the information extracted from the connection.
 * @param connection Client socket.
 * @param serverState Data structure containing the global server information.
+* @param nearCache Near cache of the calling thread.
 * @param request Data structure that holds the data from the request.
 */
-static void process_client_request(int connection, serverState_t *serverState, request_t *request);
+static void process_client_request(int connection, serverState_t *serverState, nearCache_t *nearCache,
+                                   request_t *request);
 
 /**
 * @brief Function in charge of monitoring and handling connection with clients.
@@ -52,36 +101,63 @@ void    *request_monitor(void *state);
 // Function in charge of tokenizing the received request
 static int  tokenize_request(char *str, request_t *request)
 {
-    int requestIterator = 0;
+    int     requestIterator = 0;
+    char    *savePtr;
 
     if (!str)
         return ERROR;
 
-    for (char *token = strtok(str, " "); token && *token; token = strtok(NULL, " "))
+    request->ttl = 0;
+    request->command = REQUEST_GET;
+    request->count = HEAVY_HITTERS_DEFAULT_K;
+
+    // strtok_r keeps the tokenizer state local, since every thread of the pool tokenizes concurrently
+    for (char *token = strtok_r(str, " ", &savePtr); token && *token; token = strtok_r(NULL, " ", &savePtr))
     {
         switch (++requestIterator)
         {
-            // The first element has to be a 'get' method
+            // The first element has to be a 'get' method, or one of the 'stats', 'topk' and 'dump' commands
             case 1:
-                if (strcmp(token, "get"))
+                token[strcspn(token, "\n")] = '\0';
+                if (!strcmp(token, "stats"))
+                    request->command = REQUEST_STATS;
+                else if (!strcmp(token, "topk"))
+                    request->command = REQUEST_TOPK;
+                else if (!strcmp(token, "dump"))
+                    request->command = REQUEST_DUMP;
+                else if (strcmp(token, "get"))
                     return ERROR;
-                else
-                    break;
-            // The second element is the string to be hashed
+                break;
+            // The second element is the string to be hashed, or the number of keys listed by 'topk'
             case 2:
-                request->msg = strdup(token);
+                if (request->command == REQUEST_TOPK)
+                    request->count = strtoul(token, NULL, 10);
+                else if (request->command == REQUEST_GET)
+                    request->msg = strdup(token);
+                else
+                    return ERROR;
                 break;
             // The first element is the timeout value
             case 3:
                 request->mseconds = strtoul(token, NULL, 10);
                 break;
+            // The optional fourth element is the TTL of the cached element, in seconds
+            case 4:
+                request->ttl = strtoul(token, NULL, 10);
+                break;
             default:
                 return ERROR;
         }
     }
 
+    // Commands don't take more than their own arguments
+    if (request->command == REQUEST_STATS || request->command == REQUEST_DUMP)
+        return requestIterator == 1 ? SUCCESS : ERROR;
+    if (request->command == REQUEST_TOPK)
+        return requestIterator <= 2 && request->count > 0 ? SUCCESS : ERROR;
+
     // Condition to check if the request has the expected number of fields
-    if (requestIterator != REQUEST_FIELDS)
+    if (requestIterator < REQUEST_FIELDS || requestIterator > REQUEST_MAX_FIELDS)
         return ERROR;
 
     return SUCCESS;
@@ -130,26 +206,192 @@ static bool read_client_request(request_t *request, int *connection)
         return false;
     }
 
+    // The request is hashed only once, for the cache, its disk tier and the in-flight table
+    if (request->command == REQUEST_GET)
+        request->hash = lru_hash_request(request->msg);
+
     return true;
 }
 
+// Searches for a request in the near cache of the thread, then in the current cache, and in the disk tier
+static bool cache_lookup(serverState_t *serverState, nearCache_t *nearCache, request_t *request, uint8_t *md5,
+                         bool repeated)
+{
+    lruCache_t  *cache;
+    uint64_t    expiry = 0;
+    bool        cached;
+
+    // The cache is pinned while it's used, since a flush can replace it at any time
+    epoch_enter();
+    cache = load_acquire(serverState->lruCache);
+
+    // Hot requests are served by the thread itself, as long as they were cached by the current cache
+    if (repeated == false && near_cache_get(nearCache, request->msg, request->hash, cache->generation, md5))
+    {
+        epoch_exit();
+        cache_stats_add(hits, 1);
+        cache_stats_add(nearHits, 1);
+        return true;
+    }
+
+    if (repeated)
+        cached = lru_cache_peek_element(cache, request->msg, request->hash, md5, &expiry) != NULL;
+    else
+        cached = lru_cache_get_element(cache, request->msg, request->hash, md5, &expiry) != NULL;
+
+    // Elements found in the disk tier are promoted back to memory
+    if (cached == false && serverState->diskTier &&
+        disk_tier_take(serverState->diskTier, request->msg, request->hash, md5, &expiry))
+    {
+        lru_cache_restore_node(cache, request->msg, request->hash, md5, expiry);
+        cache_stats_add(tierHits, 1);
+        cached = true;
+    }
+
+    if (cached)
+        near_cache_put(nearCache, request->msg, request->hash, cache->generation, md5, expiry);
+    epoch_exit();
+
+    return cached;
+}
+
+// Inserts a request and its digest in the current cache, and records it in the insert log if it was taken
+static void cache_insert(serverState_t *serverState, nearCache_t *nearCache, request_t *request, uint8_t *md5)
+{
+    lruCache_t      *cache;
+    unsigned int    ttl;
+    uint64_t        expiry;
+    uint64_t        generation;
+    bool            inserted;
+
+    epoch_enter();
+    cache = load_acquire(serverState->lruCache);
+    ttl = request->ttl ? request->ttl : cache->defaultTtl;
+    generation = cache->generation;
+    inserted = lru_cache_update_node(cache, request->msg, request->hash, md5, request->ttl, &expiry);
+    if (inserted)
+        near_cache_put(nearCache, request->msg, request->hash, generation, md5, expiry);
+    epoch_exit();
+
+    // Requests rejected by the cache, or already inserted by another thread, aren't logged: a replay
+    // would bring back the elements refused by the admission filter. The log is only buffered
+    if (inserted && serverState->insertLog)
+        insert_log_append(serverState->insertLog, request->msg, md5, ttl, generation);
+}
+
+// Sends the statistics of the cache to a client
+static void send_cache_stats(int connection, serverState_t *serverState)
+{
+    cacheStats_t    stats;
+    lruCache_t      *cache;
+    char            response[SEND_STATS_SIZE];
+    size_t          elements;
+    size_t          bytes;
+    size_t          capacity;
+    size_t          byteCapacity;
+    const char      *hugePages;
+    uint64_t        lookups;
+    double          uptime = (lru_clock_ms() - serverState->startTime) / 1000.0;
+    int             length;
+
+    cache_stats_read(&stats);
+    lookups = stats.hits + stats.misses;
+
+    epoch_enter();
+    cache = load_acquire(serverState->lruCache);
+    lru_cache_usage(cache, &elements, &bytes);
+    capacity = cache->totalCapacity;
+    byteCapacity = cache->totalBytes;
+    hugePages = lru_cache_page_backing(cache);
+    epoch_exit();
+
+    length = snprintf(response, SEND_STATS_SIZE,
+                      "hits %lu\nmisses %lu\nnear_hits %lu\ntier_hits %lu\nhit_ratio %.4f\ninserts %lu\n"
+                      "rejections %lu\nevictions %lu\nevictions_per_second %.2f\nexpirations %lu\ndemotions %lu\n"
+                      "elements %zu\ncapacity %zu\nbytes %zu\nbyte_capacity %zu\nhuge_pages %s\nuptime %.0f\n",
+                      stats.hits, stats.misses, stats.nearHits, stats.tierHits,
+                      lookups ? (double)stats.hits / lookups : 0.0, stats.inserts, stats.rejections, stats.evictions,
+                      uptime > 0 ? stats.evictions / uptime : 0.0, stats.expirations, stats.demotions, elements,
+                      capacity, bytes, byteCapacity, hugePages, uptime);
+    send(connection, response, length, 0);
+}
+
+// Sends the most requested keys to a client
+static void send_heavy_hitters(int connection, serverState_t *serverState, size_t k)
+{
+    heavyHitter_t   top[HEAVY_HITTERS_SIZE];
+    char            *response;
+    size_t          length = 0;
+
+    if (k > HEAVY_HITTERS_SIZE)
+        k = HEAVY_HITTERS_SIZE;
+    k = heavy_hitters_top(serverState->heavyHitters, top, k);
+
+    // Every line holds two 20-digit counts, a request and three separators
+    response = malloc(k * (MAXREQUESTSIZE + 44) + 1);
+    for (size_t i = 0; i < k; i++)
+    {
+        length += sprintf(response + length, "%lu %lu %s\n", top[i].count, top[i].error, top[i].request);
+        free(top[i].request);
+    }
+
+    if (length)
+        send(connection, response, length, 0);
+    free(response);
+}
+
+// Streams every cached element to a client
+static void send_cache_dump(int connection, serverState_t *serverState)
+{
+    // The cache is only pinned and its shards locked while each chunk is formatted, never while it's
+    // sent, and a flush ends the dump
+    cache_dump(&(serverState->lruCache), connection);
+}
+
 // Function in charge of processing the request received from the client
-static void process_client_request(int connection, serverState_t *serverState, request_t *request)
+static void process_client_request(int connection, serverState_t *serverState, nearCache_t *nearCache,
+                                   request_t *request)
 {
-    uint8_t *md5 = NULL;
+    uint8_t         md5[MD5_DIGEST_SIZE];
+    char            response[MD5_STRING_SIZE];
+    inflightEntry_t *inflight;
 
-    // Condition to check if the request message is already present in the cache
-    if ((md5 = lru_cache_get_element(serverState->lruCache, request->msg)), !md5)
+    if (request->command != REQUEST_GET)
     {
-        md5 = md5String(request->msg);
-        usleep(request->mseconds * 1000);
-        lru_cache_update_node(serverState->lruCache, request->msg, md5);
+        if (request->command == REQUEST_STATS)
+            send_cache_stats(connection, serverState);
+        else if (request->command == REQUEST_DUMP)
+            send_cache_dump(connection, serverState);
+        else
+            send_heavy_hitters(connection, serverState, request->count);
+        close(connection);
+        return;
     }
 
-    send(connection, md5, 32, 0);
-    send(connection, "\n", 1, 0);
+    heavy_hitters_record(serverState->heavyHitters, request->msg, request->hash);
 
+    // Concurrent misses of the same request wait for the first one to compute and cache it
+    if (cache_lookup(serverState, nearCache, request, md5, false) == false &&
+        (inflight = inflight_table_acquire(serverState->inflightTable, request->msg, request->hash, md5)) != NULL)
+    {
+        // The previous leader may have cached it between the miss and the registration
+        if (cache_lookup(serverState, nearCache, request, md5, true) == false)
+        {
+            md5Digest(request->msg, md5);
+            usleep(request->mseconds * 1000);
+            cache_insert(serverState, nearCache, request, md5);
+        }
+        inflight_table_publish(serverState->inflightTable, inflight, md5);
+    }
+
+    // The digest is hex-encoded straight into the response, followed by its newline
+    md5ToHex(md5, response);
+    response[MD5_STRING_SIZE - 1] = '\n';
+    send(connection, response, MD5_STRING_SIZE, 0);
+
+    request->hash = 0;
     request->mseconds = 0;
+    request->ttl = 0;
     safe_free(request->msg);
     close(connection);
 }
@@ -159,11 +401,15 @@ void    *request_monitor(void *state)
 {
     serverState_t   *serverState = (serverState_t *)state;
     linked_queue_t  *queue = (linked_queue_t *)serverState->requestQueue;
+    nearCache_t     *nearCache = near_cache_init();
     int             *clientSocket;
     request_t       request;
-    
+
+
     request.msg = NULL;
+    request.hash = 0;
     request.mseconds = 0;
+    request.ttl = 0;
 
     while (serverHandler & SERVER_ENABLED)
     {
@@ -172,13 +418,21 @@ void    *request_monitor(void *state)
         clientSocket = linked_queue_pop_ex(queue);
         pthread_mutex_unlock(&serverState->queueMutex);
 
-        // Read the request from the client socket 
-        if (read_client_request(&request, clientSocket) == false)
-            continue;
+        // Read the request from the client socket and process it
+        if (read_client_request(&request, clientSocket) == true)
+            process_client_request(*clientSocket, state, nearCache, &request);
+
+        safe_free(clientSocket);
 
-        // Function in charge of processing the request
-        process_client_request(*clientSocket, state, &request);
+        // Before waiting for more connections, the buffered hits are handed to the eviction policy
+        if (load_relaxed(queue->elements) == 0)
+        {
+            epoch_enter();
+            lru_cache_drain_recency(load_acquire(serverState->lruCache));
+            epoch_exit();
+        }
     }
 
+    near_cache_free(nearCache);
     pthread_exit(NULL);
 }
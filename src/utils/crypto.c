@@ -59,6 +59,20 @@ static void md5Step(uint32_t *buffer, uint32_t *input);
 */
 char    *hash_to_string(uint8_t *p, char *opt);
 
+/**
+ * @brief Computes the raw MD5 digest of an input message.
+ * @param input String that'll be turned to a MD5 hash.
+ * @param digest Buffer (MD5_DIGEST_SIZE bytes) where the digest is stored.
+ */
+void    md5Digest(char *input, uint8_t *digest);
+
+/**
+ * @brief Writes a MD5 digest as 32 hexadecimal characters, without any terminator.
+ * @param digest Digest to be written.
+ * @param output Buffer (at least 32 bytes) where the characters are written.
+ */
+void    md5ToHex(uint8_t *digest, char *output);
+
 /**
  * @brief Wrapper function in charge of turning an input message to a MD5 hash.
  * @param input String that'll be turned to a MD5 hash.
@@ -256,23 +270,36 @@ static void md5Step(uint32_t *buffer, uint32_t *input)
     buffer[3] += DD;
 }
 
-// Wrapper function in charge of turning an input message to a MD5 hash
-char    *md5String(char *input)
+// Computes the raw MD5 digest of an input message
+void    md5Digest(char *input, uint8_t *digest)
 {
     MD5Context_t ctx;
     md5Init(&ctx);
     md5Update(&ctx, (uint8_t *)input, strlen(input));
     md5Finalize(&ctx);
 
-    char *result = calloc(33, sizeof(char));
+    memcpy(digest, ctx.digest, MD5_DIGEST_SIZE);
+}
 
-    // Turns the uint8_t array into a C string
-    for (size_t i = 0; i < 16; i++)
+// Writes a MD5 digest as 32 hexadecimal characters, without any terminator
+void    md5ToHex(uint8_t *digest, char *output)
+{
+    for (size_t i = 0; i < MD5_DIGEST_SIZE; i++)
     {
-        result[(i * 2) + 0] = hex[((ctx.digest[i] & 0xF0) >> 4)];
-        result[(i * 2) + 1] = hex[((ctx.digest[i] & 0x0F) >> 0)];
+        output[(i * 2) + 0] = hex[((digest[i] & 0xF0) >> 4)];
+        output[(i * 2) + 1] = hex[((digest[i] & 0x0F) >> 0)];
     }
+}
 
+// Wrapper function in charge of turning an input message to a MD5 hash
+char    *md5String(char *input)
+{
+    uint8_t digest[MD5_DIGEST_SIZE];
+    char    *result = calloc(MD5_STRING_SIZE, sizeof(char));
+
+    // Turns the uint8_t array into a C string
+    md5Digest(input, digest);
+    md5ToHex(digest, result);
     result[32] = '\0';
 
     return result;
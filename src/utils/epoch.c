@@ -0,0 +1,261 @@
+/*
+ * [meteoserver]
+ * epoch.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Epoch-based reclamation:
+ *   - Readers pin the current global epoch while they traverse shared data without locks.
+ *   - Memory unlinked by writers is retired with the epoch it was unlinked in, and it's
+ *     only freed once every pinned thread has moved past that epoch.
+ *   - Structures that can't simply be freed, like a whole cache, are released after
+ *     epoch_synchronize, that waits for every reader pinned before the call.
+ *   - Short-lived threads give their record back with epoch_unregister before they exit, so
+ *     its slot can be claimed again by a later thread.
+ */
+
+
+/* Global epoch, only advanced when a thread tries to reclaim memory */
+static uint64_t         globalEpoch = 1;
+
+/* Number of records ever claimed and the per-thread records */
+static uint32_t         epochThreadNumber = 0;
+static epochThread_t    epochThreads[EPOCH_MAX_THREADS];
+
+/* Record of the calling thread, registered the first time it enters the epoch */
+static __thread epochThread_t *epochSelf = NULL;
+
+
+/**
+* @brief Returns the record of the calling thread, registering it if needed.
+* @return Record of the calling thread.
+*/
+epochThread_t *epoch_thread();
+
+/**
+* @brief Frees the retired memory of the calling thread and gives its record back, so another thread can
+*        claim it. Must be called from outside the epoch, before the thread exits.
+*/
+void epoch_unregister();
+
+/**
+* @brief Pins the current global epoch. Calls can be nested.
+*/
+void epoch_enter();
+
+/**
+* @brief Unpins the calling thread and reclaims its retired memory when there's enough of it.
+*/
+void epoch_exit();
+
+/**
+* @brief Defers the release of memory that has been unlinked from a shared structure.
+* @param ptr Pointer to be freed once no reader can reach it.
+*/
+void epoch_retire(void *ptr);
+
+/**
+* @brief Waits until every thread pinned before the call has unpinned, so nothing unlinked before
+*        the call can be reached anymore. Must be called from outside the epoch.
+*/
+void epoch_synchronize();
+
+/**
+* @brief Frees the retired memory of a thread that no pinned reader can still reach.
+* @param self Record of the thread whose memory is reclaimed.
+*/
+static void epoch_reclaim(epochThread_t *self);
+
+/**
+* @brief Frees every retired pointer. Only safe once no reader is left.
+*/
+void epoch_free_all();
+
+
+
+/* Definitions */
+
+
+// Returns the record of the calling thread, registering it if needed
+epochThread_t *epoch_thread()
+{
+    uint32_t id;
+
+    if (epochSelf)
+        return epochSelf;
+
+    // Records given back by other threads are claimed first. A new one may be claimed by another
+    // thread between its allocation and its claim, so every record is claimed the same way
+    for (id = 0; ; id++)
+    {
+        if (id >= load_acquire(epochThreadNumber))
+            id = __atomic_fetch_add(&epochThreadNumber, 1, __ATOMIC_RELAXED);
+        if (id >= EPOCH_MAX_THREADS)
+        {
+            fprintf(stderr, "Error: Too many threads registered in the epoch.\n");
+            exit(ERROR);
+        }
+
+        if (load_relaxed(epochThreads[id].claimed) == false &&
+            __atomic_exchange_n(&(epochThreads[id].claimed), true, __ATOMIC_ACQUIRE) == false)
+            break;
+    }
+
+    epochSelf = &(epochThreads[id]);
+    epochSelf->id = id;
+    return epochSelf;
+}
+
+// Frees the retired memory of the calling thread and gives its record back
+void epoch_unregister()
+{
+    epochThread_t *self = epochSelf;
+
+    if (self == NULL)
+        return;
+
+    // Nothing this thread retired can be reached once every reader pinned before has unpinned
+    if (self->retiredCount)
+        epoch_synchronize();
+    for (size_t i = 0; i < self->retiredCount; i++)
+        free(self->retired[i].ptr);
+
+    safe_free(self->retired);
+    self->retiredCount = 0;
+    self->retiredSize = 0;
+    self->depth = 0;
+    epochSelf = NULL;
+    store_release(self->claimed, false);
+}
+
+// Pins the current global epoch. Calls can be nested
+void epoch_enter()
+{
+    epochThread_t *self = epoch_thread();
+
+    if (self->depth++)
+        return;
+
+    store_relaxed(self->active, load_relaxed(globalEpoch));
+
+    // Either the reclaimer sees this thread pinned, or this thread sees the unlinked data
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Unpins the calling thread and reclaims its retired memory when there's enough of it
+void epoch_exit()
+{
+    epochThread_t *self = epoch_thread();
+
+    if (--self->depth)
+        return;
+
+    store_release(self->active, 0);
+
+    if (self->retiredCount >= EPOCH_RECLAIM_THRESHOLD)
+        epoch_reclaim(self);
+}
+
+// Defers the release of memory that has been unlinked from a shared structure
+void epoch_retire(void *ptr)
+{
+    epochThread_t *self = epoch_thread();
+
+    if (!ptr)
+        return;
+
+    if (self->retiredCount == self->retiredSize)
+    {
+        self->retiredSize = self->retiredSize ? self->retiredSize * 2 : EPOCH_RECLAIM_THRESHOLD * 2;
+        self->retired = realloc(self->retired, self->retiredSize * sizeof(epochRetired_t));
+    }
+
+    self->retired[self->retiredCount].ptr = ptr;
+    self->retired[self->retiredCount].epoch = load_relaxed(globalEpoch);
+    self->retiredCount++;
+}
+
+// Waits until every thread pinned before the call has unpinned
+void epoch_synchronize()
+{
+    uint64_t    epoch;
+    uint64_t    active;
+    uint32_t    threadNumber;
+
+    // Readers that pin from now on can't reach anything unlinked so far
+    epoch = __atomic_add_fetch(&globalEpoch, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    threadNumber = load_acquire(epochThreadNumber);
+    if (threadNumber > EPOCH_MAX_THREADS)
+        threadNumber = EPOCH_MAX_THREADS;
+
+    for (uint32_t i = 0; i < threadNumber; i++)
+    {
+        while ((active = load_acquire(epochThreads[i].active)) && active < epoch)
+            usleep(EPOCH_WAIT_US);
+    }
+}
+
+// Frees the retired memory of a thread that no pinned reader can still reach
+static void epoch_reclaim(epochThread_t *self)
+{
+    uint64_t    minActive = UINT64_MAX;
+    uint64_t    active;
+    uint32_t    threadNumber;
+    size_t      kept = 0;
+
+    // Readers that pin from now on can't reach anything retired so far
+    __atomic_fetch_add(&globalEpoch, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    threadNumber = load_acquire(epochThreadNumber);
+    if (threadNumber > EPOCH_MAX_THREADS)
+        threadNumber = EPOCH_MAX_THREADS;
+
+    for (uint32_t i = 0; i < threadNumber; i++)
+    {
+        active = load_acquire(epochThreads[i].active);
+        if (active && active < minActive)
+            minActive = active;
+    }
+
+    for (size_t i = 0; i < self->retiredCount; i++)
+    {
+        if (self->retired[i].epoch < minActive)
+            free(self->retired[i].ptr);
+        else
+            self->retired[kept++] = self->retired[i];
+    }
+    self->retiredCount = kept;
+}
+
+// Frees every retired pointer. Only safe once no reader is left
+void epoch_free_all()
+{
+    uint32_t threadNumber = load_acquire(epochThreadNumber);
+
+    if (threadNumber > EPOCH_MAX_THREADS)
+        threadNumber = EPOCH_MAX_THREADS;
+
+    for (uint32_t i = 0; i < threadNumber; i++)
+    {
+        for (size_t j = 0; j < epochThreads[i].retiredCount; j++)
+            free(epochThreads[i].retired[j].ptr);
+
+        safe_free(epochThreads[i].retired);
+        epochThreads[i].retiredCount = 0;
+        epochThreads[i].retiredSize = 0;
+    }
+}
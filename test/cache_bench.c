@@ -0,0 +1,287 @@
+/*
+ * [meteoserver]
+ * cache_bench.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "meteoserver.h"
+
+
+/*
+ * Benchmark of the cache on its own, without the network nor the digests:
+ *   - Fills a cache with short requests and reports the memory taken by each element, both
+ *     as charged to the byte budget and as measured by the resident set of the process.
+ *   - Looks up random requests from several threads, half of them cached, and reports the
+ *     throughput and the average time of a lookup. The cache is meant to be much bigger than
+ *     the last level cache, so the time is dominated by the cache misses of each lookup.
+ *   - Looks up the same kind of requests in batches of CACHE_PREFETCH_BATCH, whose cache
+ *     misses overlap.
+ *   - Inserts random requests into the full cache, so every insert evicts a victim.
+ *   - With 'huge' as the last argument, the arrays of the cache are backed by huge pages, which
+ *     spares most of the TLB misses of the lookups in a big cache.
+ *
+ * Usage: cache_bench [elements] [threads] [lookups per thread] [huge]
+ */
+
+
+/* Arguments shared by the threads of the benchmark */
+typedef struct          benchArgs
+{
+    lruCache_t          *cache;
+    char                **requests;
+    size_t              elements;
+    size_t              operations;
+    unsigned int        seed;
+    size_t              hits;
+}                       benchArgs_t;
+
+
+/**
+* @brief Returns the time of a monotonic clock, in seconds.
+* @return Current time.
+*/
+static double bench_clock();
+
+/**
+* @brief Returns the resident set size of the process.
+* @return Resident memory in bytes.
+*/
+static size_t bench_resident_bytes();
+
+/**
+* @brief Picks a random request out of twice the number of cached ones, so half of them miss.
+* @param seed State of the random generator of the thread.
+* @param elements Number of cached requests.
+* @return Index of the request.
+*/
+static size_t bench_random(unsigned int *seed, size_t elements);
+
+/**
+* @brief Looks up random requests in the cache.
+* @param args Arguments of the thread.
+*/
+static void *bench_lookups(void *args);
+
+/**
+* @brief Looks up random requests in the cache, in batches.
+* @param args Arguments of the thread.
+*/
+static void *bench_batched_lookups(void *args);
+
+/**
+* @brief Inserts random requests in the cache.
+* @param args Arguments of the thread.
+*/
+static void *bench_inserts(void *args);
+
+/**
+* @brief Runs one of the phases of the benchmark in several threads and prints its results.
+* @param name Name of the phase.
+* @param routine Routine run by each thread.
+* @param args Arguments of the threads.
+* @param threads Number of threads.
+*/
+static void bench_run(char *name, void *(*routine)(void *), benchArgs_t *args, size_t threads);
+
+
+
+/* Definitions */
+
+
+// Returns the time of a monotonic clock, in seconds
+static double bench_clock()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Returns the resident set size of the process
+static size_t bench_resident_bytes()
+{
+    FILE    *file = fopen("/proc/self/statm", "r");
+    size_t  pages = 0;
+
+    if (file)
+    {
+        if (fscanf(file, "%*s %zu", &pages) != 1)
+            pages = 0;
+        fclose(file);
+    }
+
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+// Picks a random request out of twice the number of cached ones
+static size_t bench_random(unsigned int *seed, size_t elements)
+{
+    return ((size_t)rand_r(seed) * RAND_MAX + rand_r(seed)) % (elements * 2);
+}
+
+// Looks up random requests in the cache
+static void *bench_lookups(void *arg)
+{
+    benchArgs_t *args = (benchArgs_t *)arg;
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    char        *request;
+
+    for (size_t i = 0; i < args->operations; i++)
+    {
+        request = args->requests[bench_random(&(args->seed), args->elements)];
+        if (lru_cache_get_element(args->cache, request, lru_hash_request(request), md5, NULL))
+            args->hits++;
+    }
+
+    return NULL;
+}
+
+// Looks up random requests in the cache, in batches
+static void *bench_batched_lookups(void *arg)
+{
+    benchArgs_t *args = (benchArgs_t *)arg;
+    uint8_t     md5s[CACHE_PREFETCH_BATCH * MD5_DIGEST_SIZE];
+    bool        found[CACHE_PREFETCH_BATCH];
+    char        *batch[CACHE_PREFETCH_BATCH];
+    uint64_t    hashes[CACHE_PREFETCH_BATCH];
+
+    // Requests are hashed as they're parsed, like the server does
+    for (size_t i = 0; i < args->operations / CACHE_PREFETCH_BATCH; i++)
+    {
+        for (size_t j = 0; j < CACHE_PREFETCH_BATCH; j++)
+        {
+            batch[j] = args->requests[bench_random(&(args->seed), args->elements)];
+            hashes[j] = lru_hash_request(batch[j]);
+        }
+        args->hits += lru_cache_get_many(args->cache, batch, hashes, CACHE_PREFETCH_BATCH, md5s, found);
+    }
+
+    return NULL;
+}
+
+// Inserts random requests in the cache
+static void *bench_inserts(void *arg)
+{
+    benchArgs_t *args = (benchArgs_t *)arg;
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    char        *request;
+
+    for (size_t i = 0; i < args->operations / 4; i++)
+    {
+        request = args->requests[bench_random(&(args->seed), args->elements)];
+        lru_cache_update_node(args->cache, request, lru_hash_request(request), md5, 0, NULL);
+    }
+
+    return NULL;
+}
+
+// Runs one of the phases of the benchmark in several threads and prints its results
+static void bench_run(char *name, void *(*routine)(void *), benchArgs_t *args, size_t threads)
+{
+    pthread_t   *workers = calloc(threads, sizeof(pthread_t));
+    size_t      operations = 0;
+    size_t      hits = 0;
+    double      elapsed = bench_clock();
+
+    for (size_t i = 0; i < threads; i++)
+        pthread_create(&(workers[i]), NULL, routine, &(args[i]));
+    for (size_t i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+    elapsed = bench_clock() - elapsed;
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        if (routine == bench_inserts)
+            operations += args[i].operations / 4;
+        else if (routine == bench_batched_lookups)
+            operations += args[i].operations / CACHE_PREFETCH_BATCH * CACHE_PREFETCH_BATCH;
+        else
+            operations += args[i].operations;
+        hits += args[i].hits;
+        args[i].hits = 0;
+    }
+
+    printf("%-8s %10.2f Mops/s %8.1f ns/op", name, operations / elapsed / 1e6, elapsed * 1e9 * threads / operations);
+    if (routine != bench_inserts)
+        printf(" %6.1f%% hits", 100.0 * hits / operations);
+    printf("\n");
+    free(workers);
+}
+
+
+/* main */
+
+int main(int argc, char **argv)
+{
+    arguments_t settings = {0};
+    benchArgs_t *args;
+    lruCache_t  *cache;
+    char        **requests;
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    size_t      elements = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t      threads = argc > 2 ? strtoull(argv[2], NULL, 10) : 4;
+    size_t      operations = argc > 3 ? strtoull(argv[3], NULL, 10) : 4000000;
+    size_t      resident;
+
+    if (elements == 0 || threads == 0 || elements > INT_MAX)
+    {
+        fprintf(stderr, "Usage: %s [elements] [threads] [lookups per thread] [huge]\n", argv[0]);
+        return ERROR;
+    }
+
+    // Requests of the benchmark, the second half of them never cached
+    requests = malloc(elements * 2 * sizeof(char *));
+    for (size_t i = 0; i < elements * 2; i++)
+    {
+        requests[i] = malloc(24);
+        snprintf(requests[i], 24, "bench:%zu", i);
+    }
+
+    settings.cacheSize = elements;
+    settings.shardNumber = CACHE_SHARD_NUMBER;
+    settings.policy = &lruPolicy;
+    settings.hugePages = argc > 4 && !strcmp(argv[4], "huge");
+
+    resident = bench_resident_bytes();
+    if ((cache = lru_cache_init(&settings)) == NULL)
+        return ERROR;
+    for (size_t i = 0; i < elements; i++)
+        lru_cache_update_node(cache, requests[i], lru_hash_request(requests[i]), md5, 0, NULL);
+    resident = bench_resident_bytes() - resident;
+
+    printf("%zu elements, %zu threads, %zu lookups per thread, huge pages: %s\n", elements, threads, operations,
+           lru_cache_page_backing(cache));
+    printf("Element size: %zu bytes charged, %.1f bytes resident\n", lru_entry_size(strlen(requests[0])),
+           (double)resident / elements);
+
+    args = calloc(threads, sizeof(benchArgs_t));
+    for (size_t i = 0; i < threads; i++)
+    {
+        args[i].cache = cache;
+        args[i].requests = requests;
+        args[i].elements = elements;
+        args[i].operations = operations;
+        args[i].seed = i + 1;
+    }
+
+    bench_run("lookup", bench_lookups, args, threads);
+    bench_run("get_many", bench_batched_lookups, args, threads);
+    bench_run("insert", bench_inserts, args, threads);
+
+    lru_cache_free(cache);
+    free(cache);
+    for (size_t i = 0; i < elements * 2; i++)
+        free(requests[i]);
+    free(requests);
+    free(args);
+    epoch_free_all();
+
+    return SUCCESS;
+}
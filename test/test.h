@@ -0,0 +1,81 @@
+/*
+ * [meteoserver]
+ * test.h
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#ifndef METEOSERVER_TEST_H
+#define METEOSERVER_TEST_H
+
+#include "meteoserver.h"
+
+
+/*
+ * Helpers shared by the tests of the cache, run by 'make check':
+ *   - Each test is a program of its own, linked against the objects of the server but its
+ *     networking, that exits with an error when any of its checks fails.
+ *   - Requests are inserted with their real digests, so the digest found can be checked too.
+ */
+
+
+/* Number of checks of the test that failed */
+static int testFailures = 0;
+
+
+// Checks a condition of the test, reporting it when it doesn't hold
+#define test_check(condition)   if (!(condition)) {fprintf(stderr, "%s:%d: Check failed: '%s'.\n", \
+                                __FILE__, __LINE__, #condition); testFailures++;}
+
+// Result of the test, to be returned by its main
+#define test_result()           (printf("%s: %s\n", __FILE__, testFailures ? "FAILED" : "OK"), \
+                                 testFailures ? ERROR : SUCCESS)
+
+
+// Builds a cache of a number of elements and shards, with the given policy
+static inline lruCache_t *test_cache(int size, int shards, const cachePolicy_t *policy, bool admission)
+{
+    arguments_t settings = {0};
+
+    settings.cacheSize = size;
+    settings.shardNumber = shards;
+    settings.policy = policy;
+    settings.admission = admission;
+
+    return lru_cache_init(&settings);
+}
+
+// Frees a cache built by test_cache
+static inline void test_free(lruCache_t *cache)
+{
+    lru_cache_free(cache);
+    free(cache);
+}
+
+// Inserts a request with its digest, and an optional TTL in seconds, returning whether the cache took it
+static inline bool test_insert(lruCache_t *cache, char *request, unsigned int ttl)
+{
+    uint8_t md5[MD5_DIGEST_SIZE];
+
+    md5Digest(request, md5);
+    return lru_cache_update_node(cache, request, lru_hash_request(request), md5, ttl, NULL);
+}
+
+// Checks whether a request is cached with its digest, counting the lookup as a hit
+static inline bool test_cached(lruCache_t *cache, char *request)
+{
+    uint8_t md5[MD5_DIGEST_SIZE];
+    uint8_t expected[MD5_DIGEST_SIZE];
+
+    md5Digest(request, expected);
+    return lru_cache_get_element(cache, request, lru_hash_request(request), md5, NULL) &&
+           !memcmp(md5, expected, MD5_DIGEST_SIZE);
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * [meteoserver]
+ * test_admission.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the TinyLFU admission filter: its sketch saturates its packed counters without
+ * touching their neighbours, and a full cache only admits requests more frequent than its victim.
+ */
+
+
+/**
+* @brief Counters saturate at TINYLFU_MAX_COUNT, and unseen requests estimate zero.
+*/
+static void test_sketch();
+
+/**
+* @brief A one-off request is rejected by a full cache, and a repeated one is admitted.
+*/
+static void test_admission();
+
+
+
+/* Definitions */
+
+
+// Counters saturate, and unseen requests estimate zero
+static void test_sketch()
+{
+    tinyLfu_t   *lfu = tiny_lfu_init(64);
+    uint64_t    hot = lru_hash_request("hot");
+    uint64_t    warm = lru_hash_request("warm");
+
+    // The first occurrence only sets the doorkeeper
+    tiny_lfu_increment(lfu, warm);
+    test_check(tiny_lfu_estimate(lfu, warm) == 1);
+    tiny_lfu_increment(lfu, warm);
+    tiny_lfu_increment(lfu, warm);
+    test_check(tiny_lfu_estimate(lfu, warm) == 3);
+
+    for (int i = 0; i < 2 * TINYLFU_MAX_COUNT; i++)
+        tiny_lfu_increment(lfu, hot);
+    test_check(tiny_lfu_estimate(lfu, hot) == TINYLFU_MAX_COUNT + 1);
+    test_check(tiny_lfu_estimate(lfu, warm) == 3);
+    test_check(tiny_lfu_estimate(lfu, lru_hash_request("cold")) == 0);
+    tiny_lfu_free(lfu);
+}
+
+// A one-off request is rejected by a full cache, and a repeated one is admitted
+static void test_admission()
+{
+    lruCache_t *cache = test_cache(4, 1, &lruPolicy, true);
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_insert(cache, "c", 0);
+    test_check(test_insert(cache, "d", 0));
+    test_check(!test_insert(cache, "d", 0));
+
+    // 'once' is as frequent as the victim, 'a'
+    test_check(!test_insert(cache, "once", 0));
+    test_check(!test_cached(cache, "once"));
+    test_check(test_cached(cache, "a"));
+    lru_cache_drain_recency(cache);
+
+    // The second miss of 'twice' makes it more frequent than the victim, now 'b'
+    test_check(!test_insert(cache, "twice", 0));
+    test_check(test_insert(cache, "twice", 0));
+    test_check(test_cached(cache, "twice"));
+    test_check(!test_cached(cache, "b"));
+    test_check(test_cached(cache, "c"));
+    test_check(test_cached(cache, "d"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_sketch();
+    test_admission();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,152 @@
+/*
+ * [meteoserver]
+ * test_batch.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the batched lookups: lru_cache_get_many resolves every request of a batch of any
+ * size like a lookup of its own would, counting its hits and misses and reporting its hits to
+ * the eviction policy.
+ */
+
+
+/**
+* @brief Every request of batches of several sizes is found, or missed, with its own digest.
+*/
+static void test_results();
+
+/**
+* @brief Expired elements miss, and the hits and misses of a batch are counted.
+*/
+static void test_counted();
+
+/**
+* @brief The hits of a batch protect their elements from the next eviction.
+*/
+static void test_recency();
+
+
+
+/* Definitions */
+
+
+// Every request of batches of several sizes is found, or missed, with its own digest
+static void test_results()
+{
+    lruCache_t  *cache = test_cache(1024, 4, &lruPolicy, false);
+    char        *requests[100];
+    uint64_t    hashes[100];
+    uint8_t     md5s[100 * MD5_DIGEST_SIZE];
+    uint8_t     expected[MD5_DIGEST_SIZE];
+    bool        found[100];
+    size_t      hits;
+    bool        matched = true;
+
+    // Even requests are cached, odd ones aren't
+    for (int i = 0; i < 100; i++)
+    {
+        requests[i] = calloc(1, 48);
+        snprintf(requests[i], 48, i % 3 ? "batch:%d" : "batch:request:allocated:on:the:heap:%d", i);
+        hashes[i] = lru_hash_request(requests[i]);
+        if (i % 2 == 0)
+            test_insert(cache, requests[i], 0);
+    }
+
+    for (size_t count = 0; count <= 100; count += count < CACHE_PREFETCH_BATCH + 1 ? 1 : 7)
+    {
+        memset(found, true, sizeof(found));
+        hits = lru_cache_get_many(cache, requests, hashes, count, md5s, found);
+        test_check(hits == (count + 1) / 2);
+        for (size_t i = 0; i < count; i++)
+        {
+            md5Digest(requests[i], expected);
+            matched &= found[i] == (i % 2 == 0);
+            if (found[i])
+                matched &= !memcmp(md5s + i * MD5_DIGEST_SIZE, expected, MD5_DIGEST_SIZE);
+        }
+    }
+    test_check(matched);
+
+    for (int i = 0; i < 100; i++)
+        free(requests[i]);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Expired elements miss, and the hits and misses of a batch are counted
+static void test_counted()
+{
+    lruCache_t      *cache = test_cache(16, 1, &lruPolicy, false);
+    char            *requests[] = {"a", "b", "expired", "missing"};
+    uint64_t        hashes[4];
+    uint8_t         md5s[4 * MD5_DIGEST_SIZE];
+    uint8_t         md5[MD5_DIGEST_SIZE] = {0};
+    bool            found[4];
+    cacheStats_t    before;
+    cacheStats_t    after;
+
+    for (int i = 0; i < 4; i++)
+        hashes[i] = lru_hash_request(requests[i]);
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    lru_cache_restore_node(cache, "expired", hashes[2], md5, lru_clock_ms() - 1);
+
+    cache_stats_read(&before);
+    test_check(lru_cache_get_many(cache, requests, hashes, 4, md5s, found) == 2);
+    test_check(found[0] && found[1] && !found[2] && !found[3]);
+    cache_stats_read(&after);
+    test_check(after.hits - before.hits == 2 && after.misses - before.misses == 2);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// The hits of a batch protect their elements from the next eviction
+static void test_recency()
+{
+    lruCache_t  *cache = test_cache(4, 1, &lruPolicy, false);
+    char        *requests[] = {"a", "b"};
+    uint64_t    hashes[] = {lru_hash_request("a"), lru_hash_request("b")};
+    uint8_t     md5s[2 * MD5_DIGEST_SIZE];
+    bool        found[2];
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_insert(cache, "c", 0);
+    test_insert(cache, "d", 0);
+
+    test_check(lru_cache_get_many(cache, requests, hashes, 2, md5s, found) == 2);
+    lru_cache_drain_recency(cache);
+    test_insert(cache, "e", 0);
+    test_insert(cache, "f", 0);
+
+    test_check(test_cached(cache, "a") && test_cached(cache, "b"));
+    test_check(!test_cached(cache, "c") && !test_cached(cache, "d"));
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_results();
+    test_counted();
+    test_recency();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,231 @@
+/*
+ * [meteoserver]
+ * test_bytes.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the byte budget of the cache: every element is charged the memory it takes, the
+ * budget is never exceeded, as many victims are evicted as an element needs to fit, and the
+ * elements that wouldn't fit in the whole budget of their shard are rejected.
+ */
+
+
+/**
+* @brief Every element is charged its entry size, and the charges are returned once evicted.
+*/
+static void test_accounting();
+
+/**
+* @brief Elements are evicted to keep the cache within its budget, whatever the count capacity.
+*/
+static void test_budget();
+
+/**
+* @brief A long element evicts as many short ones as it needs to fit, from the least recently used.
+*/
+static void test_fit();
+
+/**
+* @brief An element bigger than the budget of its shard is rejected, without evicting anything.
+*/
+static void test_oversized();
+
+/**
+* @brief Builds a one-shard cache of a number of elements and a byte budget.
+* @param size Number of elements.
+* @param bytes Byte budget.
+* @return Cache built.
+*/
+static lruCache_t *test_budget_cache(int size, size_t bytes);
+
+/**
+* @brief Fills a buffer with a request of a given length, made of a number and padding.
+* @param request Buffer of the request.
+* @param number Number of the request.
+* @param length Length of the request.
+*/
+static void test_request(char *request, int number, size_t length);
+
+
+
+/* Definitions */
+
+
+// Builds a one-shard cache of a number of elements and a byte budget
+static lruCache_t *test_budget_cache(int size, size_t bytes)
+{
+    arguments_t settings = {0};
+
+    settings.cacheSize = size;
+    settings.shardNumber = 1;
+    settings.cacheBytes = bytes;
+    settings.policy = &lruPolicy;
+
+    return lru_cache_init(&settings);
+}
+
+// Fills a buffer with a request of a given length, made of a number and padding
+static void test_request(char *request, int number, size_t length)
+{
+    int written = sprintf(request, "bytes:%d:", number);
+
+    memset(request + written, 'x', length - written);
+    request[length] = '\0';
+}
+
+// Every element is charged its entry size, and the charges are returned once evicted
+static void test_accounting()
+{
+    lruCache_t  *cache = test_budget_cache(1024, 0);
+    char        request[256];
+    size_t      expected = 0;
+    size_t      elements;
+    size_t      bytes;
+
+    // Requests under CACHE_INLINE_KEY_SIZE are stored in the node, the rest are allocated
+    test_check(lru_entry_size(CACHE_INLINE_KEY_SIZE - 1) == lru_entry_size(0));
+    test_check(lru_entry_size(CACHE_INLINE_KEY_SIZE) == lru_entry_size(0) + CACHE_INLINE_KEY_SIZE + 1);
+
+    for (int i = 0; i < 200; i++)
+    {
+        test_request(request, i, 12 + i);
+        test_insert(cache, request, 0);
+        expected += lru_entry_size(12 + i);
+    }
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 200 && bytes == expected);
+
+    // Refreshing a cached request charges nothing
+    test_request(request, 100, 112);
+    test_check(!test_insert(cache, request, 0));
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(bytes == expected);
+    lru_cache_drain_recency(cache);
+
+    // Shrinking the cache evicts every element but the most recently used one
+    lru_cache_resize(cache, 1, 0);
+    while (lru_cache_trim(cache));
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 1 && bytes == lru_entry_size(112));
+
+    test_free(cache);
+}
+
+// Elements are evicted to keep the cache within its budget, whatever the count capacity
+static void test_budget()
+{
+    lruCache_t  *cache = test_budget_cache(1000, 10 * lru_entry_size(40));
+    char        request[64];
+    size_t      elements;
+    size_t      bytes;
+    bool        within = true;
+
+    for (int i = 0; i < 100; i++)
+    {
+        test_request(request, i, 40);
+        test_check(test_insert(cache, request, 0));
+        lru_cache_usage(cache, &elements, &bytes);
+        within &= bytes <= 10 * lru_entry_size(40);
+    }
+    test_check(within);
+    test_check(elements == 10 && bytes == 10 * lru_entry_size(40));
+
+    // The last ten requests are the ones kept
+    test_request(request, 89, 40);
+    test_check(!test_cached(cache, request));
+    test_request(request, 90, 40);
+    test_check(test_cached(cache, request));
+    test_request(request, 99, 40);
+    test_check(test_cached(cache, request));
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// A long element evicts as many short ones as it needs to fit, from the least recently used
+static void test_fit()
+{
+    size_t      budget = 10 * lru_entry_size(12);
+    lruCache_t  *cache = test_budget_cache(1000, budget);
+    char        request[1024];
+    size_t      kept = (budget - lru_entry_size(600)) / lru_entry_size(12);
+    size_t      elements;
+    size_t      bytes;
+
+    for (int i = 0; i < 10; i++)
+    {
+        test_request(request, i, 12);
+        test_insert(cache, request, 0);
+    }
+
+    // Several short elements have to make room for a long one
+    test_check(kept > 0 && kept < 9);
+    test_request(request, 10, 600);
+    test_check(test_insert(cache, request, 0));
+    test_check(test_cached(cache, request));
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == kept + 1 && bytes == kept * lru_entry_size(12) + lru_entry_size(600));
+
+    for (int i = 0; i < 10; i++)
+    {
+        test_request(request, i, 12);
+        test_check(test_cached(cache, request) == (i >= 10 - (int)kept));
+    }
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// An element bigger than the budget of its shard is rejected, without evicting anything
+static void test_oversized()
+{
+    lruCache_t      *cache = test_budget_cache(16, 4 * lru_entry_size(100));
+    char            request[1024];
+    cacheStats_t    before;
+    cacheStats_t    after;
+    size_t          elements;
+    size_t          bytes;
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+
+    cache_stats_read(&before);
+    test_request(request, 0, 4 * lru_entry_size(100));
+    test_check(!test_insert(cache, request, 0));
+    test_check(!test_cached(cache, request));
+    cache_stats_read(&after);
+    test_check(after.rejections - before.rejections == 1);
+    test_check(after.evictions == before.evictions && after.inserts == before.inserts);
+
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 2 && bytes == 2 * lru_entry_size(1));
+    test_check(test_cached(cache, "a") && test_cached(cache, "b"));
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_accounting();
+    test_budget();
+    test_fit();
+    test_oversized();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,94 @@
+/*
+ * [meteoserver]
+ * test_clock.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the CLOCK eviction policy: a hit only sets the reference bit of its node, and the
+ * hand gives referenced nodes a second chance before evicting them.
+ */
+
+
+/**
+* @brief Referenced nodes are skipped once by the hand, which evicts the first unreferenced one.
+*/
+static void test_second_chance();
+
+/**
+* @brief A full cache keeps its capacity, whatever the number of insertions.
+*/
+static void test_capacity();
+
+
+
+/* Definitions */
+
+
+// Referenced nodes are skipped once by the hand
+static void test_second_chance()
+{
+    lruCache_t *cache = test_cache(4, 1, &clockPolicy, false);
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_insert(cache, "c", 0);
+    test_insert(cache, "d", 0);
+
+    // 'a' is referenced, so the hand clears its bit and evicts 'b', and then 'c'
+    test_check(test_cached(cache, "a"));
+    test_insert(cache, "e", 0);
+    test_insert(cache, "f", 0);
+
+    test_check(test_cached(cache, "a"));
+    test_check(!test_cached(cache, "b"));
+    test_check(!test_cached(cache, "c"));
+    test_check(test_cached(cache, "d"));
+    test_check(test_cached(cache, "e"));
+    test_check(test_cached(cache, "f"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// A full cache keeps its capacity
+static void test_capacity()
+{
+    lruCache_t  *cache = test_cache(64, 4, &clockPolicy, false);
+    char        request[32];
+    size_t      elements;
+    size_t      bytes;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(request, sizeof(request), "request:%d", i);
+        test_insert(cache, request, 0);
+    }
+
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 64);
+    test_check(test_cached(cache, "request:999"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_second_chance();
+    test_capacity();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,156 @@
+/*
+ * [meteoserver]
+ * test_digest.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the raw digests: md5Digest computes the 16 bytes of the MD5 of a request, md5ToHex
+ * encodes them straight into a buffer, and the cache stores and returns them as they are.
+ */
+
+
+/**
+* @brief The digests of the test suite of RFC 1321 match, both raw and hex-encoded.
+*/
+static void test_vectors();
+
+/**
+* @brief md5ToHex writes 32 lowercase characters and nothing else.
+*/
+static void test_hex();
+
+/**
+* @brief The cache returns the 16 bytes it was given, whatever their value.
+*/
+static void test_cached_digest();
+
+/**
+* @brief Refreshing an expired element replaces its digest in place.
+*/
+static void test_refreshed_digest();
+
+
+
+/* Definitions */
+
+
+// The digests of the test suite of RFC 1321 match, both raw and hex-encoded
+static void test_vectors()
+{
+    char        *vectors[][2] = {
+        {"", "d41d8cd98f00b204e9800998ecf8427e"},
+        {"a", "0cc175b9c0f1b6a831c399e269772661"},
+        {"abc", "900150983cd24fb0d6963f7d28e17f72"},
+        {"message digest", "f96b697d7cb7938d525a2f31aaf161d0"},
+        {"abcdefghijklmnopqrstuvwxyz", "c3fcd3d76192e4007dfb496cca67e13b"},
+        {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "d174ab98d277d9f5a5611c2c9f419d9f"},
+        {"12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+         "57edf4a22be3c955ac49da2e2107b67a"}
+    };
+    uint8_t     digest[MD5_DIGEST_SIZE];
+    char        hex[MD5_STRING_SIZE];
+    char        *string;
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        md5Digest(vectors[i][0], digest);
+        md5ToHex(digest, hex);
+        hex[MD5_STRING_SIZE - 1] = '\0';
+        test_check(!strcmp(hex, vectors[i][1]));
+
+        string = md5String(vectors[i][0]);
+        test_check(!strcmp(string, vectors[i][1]));
+        free(string);
+    }
+
+    // The first bytes of the raw digest of "abc" are 0x90, 0x01 and 0x50
+    md5Digest("abc", digest);
+    test_check(digest[0] == 0x90 && digest[1] == 0x01 && digest[2] == 0x50 && digest[15] == 0x72);
+}
+
+// md5ToHex writes 32 lowercase characters and nothing else
+static void test_hex()
+{
+    uint8_t digest[MD5_DIGEST_SIZE];
+    char    buffer[MD5_STRING_SIZE + 1];
+
+    for (int i = 0; i < MD5_DIGEST_SIZE; i++)
+        digest[i] = i * 17;
+
+    memset(buffer, '#', sizeof(buffer));
+    md5ToHex(digest, buffer);
+    test_check(!memcmp(buffer, "00112233445566778899aabbccddeeff", 32));
+    test_check(buffer[32] == '#' && buffer[33] == '#');
+}
+
+// The cache returns the 16 bytes it was given, whatever their value
+static void test_cached_digest()
+{
+    lruCache_t  *cache = test_cache(16, 1, &lruPolicy, false);
+    uint8_t     digest[MD5_DIGEST_SIZE];
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    // Zero bytes aren't terminators
+    for (int i = 0; i < MD5_DIGEST_SIZE; i++)
+        digest[i] = i % 2 ? 0xff - i : 0;
+
+    test_check(sizeof(cache->shards[0].nodeData[0].md5) == MD5_DIGEST_SIZE);
+    test_check(lru_cache_update_node(cache, "digest", lru_hash_request("digest"), digest, 0, NULL));
+    memset(found, 0xaa, sizeof(found));
+    test_check(lru_cache_get_element(cache, "digest", lru_hash_request("digest"), found, NULL) == found);
+    test_check(!memcmp(found, digest, MD5_DIGEST_SIZE));
+
+    // Misses leave the buffer of the caller alone
+    memset(found, 0xaa, sizeof(found));
+    test_check(lru_cache_get_element(cache, "missing", lru_hash_request("missing"), found, NULL) == NULL);
+    test_check(found[0] == 0xaa && found[MD5_DIGEST_SIZE - 1] == 0xaa);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Refreshing an expired element replaces its digest in place
+static void test_refreshed_digest()
+{
+    lruCache_t  *cache = test_cache(16, 1, &lruPolicy, false);
+    uint8_t     stale[MD5_DIGEST_SIZE] = {0};
+    uint8_t     digest[MD5_DIGEST_SIZE];
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    test_check(lru_cache_restore_node(cache, "refresh", lru_hash_request("refresh"), stale, lru_clock_ms() - 1));
+    test_check(lru_cache_get_element(cache, "refresh", lru_hash_request("refresh"), found, NULL) == NULL);
+
+    md5Digest("refresh", digest);
+    test_check(lru_cache_update_node(cache, "refresh", lru_hash_request("refresh"), digest, 0, NULL));
+    test_check(lru_cache_get_element(cache, "refresh", lru_hash_request("refresh"), found, NULL));
+    test_check(!memcmp(found, digest, MD5_DIGEST_SIZE));
+    test_check(cache->shards[0].currentCapacity == 1);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_vectors();
+    test_hex();
+    test_cached_digest();
+    test_refreshed_digest();
+    epoch_free_all();
+
+    return test_result();
+}
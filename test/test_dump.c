@@ -0,0 +1,237 @@
+/*
+ * [meteoserver]
+ * test_dump.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the dump of the cache: every element that hasn't expired is listed once with its
+ * digest, across chunks and buffers of any size, the dump ends once the cache is flushed, and
+ * a reader that hangs up fails the dump instead of killing the server.
+ */
+
+
+/* Arguments of the thread that dumps a cache into a socket */
+typedef struct          dumpArgs
+{
+    lruCache_t          **cache;
+    int                 fd;
+    bool                written;
+}                       dumpArgs_t;
+
+
+/**
+* @brief Every element is listed once with its digest, and expired elements are left out.
+*/
+static void test_lines();
+
+/**
+* @brief A dump ends early, without failing, once the cache it's dumping is flushed.
+*/
+static void test_flushed();
+
+/**
+* @brief A dump into a socket whose reader has hung up fails.
+*/
+static void test_hung_up();
+
+/**
+* @brief Builds a cache of 1000 requests over 4 shards, one in ten of them long enough to fill
+*        the buffer of a dump with a few of them.
+* @return Cache built.
+*/
+static lruCache_t *test_dump_cache();
+
+/**
+* @brief Fills a buffer with the request of a number.
+* @param request Buffer of MAXREQUESTSIZE + 1 bytes.
+* @param number Number of the request.
+* @return The request.
+*/
+static char *test_request(char *request, int number);
+
+/**
+* @brief Dumps a cache into a socket, closing it once done.
+* @param args Arguments of the thread.
+*/
+static void *test_dumper(void *args);
+
+
+
+/* Definitions */
+
+
+// Fills a buffer with the request of a number
+static char *test_request(char *request, int number)
+{
+    int written = sprintf(request, "dump:%d:", number);
+    int length = number % 10 ? written : MAXREQUESTSIZE;
+
+    memset(request + written, 'd', length - written);
+    request[length] = '\0';
+    return request;
+}
+
+// Builds a cache of 1000 requests over 4 shards, one in ten of them long
+static lruCache_t *test_dump_cache()
+{
+    lruCache_t  *cache = test_cache(4000, 4, &lruPolicy, false);
+    char        request[MAXREQUESTSIZE + 1];
+
+    for (int i = 0; i < 1000; i++)
+        test_insert(cache, test_request(request, i), 0);
+
+    return cache;
+}
+
+// Every element is listed once with its digest, and expired elements are left out
+static void test_lines()
+{
+    lruCache_t  *cache = test_dump_cache();
+    char        path[PATH_MAX];
+    char        request[MAXREQUESTSIZE + 1];
+    char        *contents = malloc(2 << 20);
+    char        *line;
+    char        *hash;
+    char        *expected;
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    int         seen[1000] = {0};
+    int         number;
+    size_t      size;
+    size_t      lines = 0;
+    bool        matched = true;
+    int         fd;
+
+    lru_cache_restore_node(cache, "dump:expired", lru_hash_request("dump:expired"), md5, lru_clock_ms() - 1);
+    snprintf(path, PATH_MAX, "/tmp/test_dump.%d", getpid());
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    test_check(cache_dump(&cache, fd));
+
+    size = pread(fd, contents, (2 << 20) - 1, 0);
+    contents[size] = '\0';
+    for (line = strtok(contents, "\n"); line; line = strtok(NULL, "\n"))
+    {
+        lines++;
+        hash = strstr(line, "' with hash: '");
+        if (sscanf(line, "Request: 'dump:%d:", &number) != 1 || number < 0 || number >= 1000 || hash == NULL)
+        {
+            matched = false;
+            continue;
+        }
+
+        // Each request is listed whole, with its digest
+        seen[number]++;
+        test_request(request, number);
+        expected = md5String(request);
+        matched &= (size_t)(hash - line) == strlen("Request: '") + strlen(request);
+        matched &= !strncmp(line + strlen("Request: '"), request, strlen(request));
+        matched &= !strncmp(hash + strlen("' with hash: '"), expected, MD5_STRING_SIZE - 1);
+        matched &= !strcmp(hash + strlen("' with hash: '") + MD5_STRING_SIZE - 1, "'");
+        free(expected);
+    }
+    test_check(matched);
+    test_check(lines == 1000);
+    for (int i = 0; i < 1000; i++)
+        test_check(seen[i] == 1);
+
+    close(fd);
+    unlink(path);
+    free(contents);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Dumps a cache into a socket, closing it once done
+static void *test_dumper(void *arg)
+{
+    dumpArgs_t *args = (dumpArgs_t *)arg;
+
+    args->written = cache_dump(args->cache, args->fd);
+    close(args->fd);
+    epoch_unregister();
+    return NULL;
+}
+
+// A dump ends early, without failing, once the cache it's dumping is flushed
+static void test_flushed()
+{
+    lruCache_t  *cache = test_dump_cache();
+    lruCache_t  *flushed = test_cache(4000, 4, &lruPolicy, false);
+    lruCache_t  *shared = cache;
+    dumpArgs_t  args;
+    pthread_t   dumper;
+    char        *contents = calloc(1, 1 << 20);
+    char        request[32];
+    size_t      dumped = 0;
+    ssize_t     size;
+    int         fds[2];
+    int         sendBuffer = 4096;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(request, sizeof(request), "flushed:%d", i);
+        test_insert(flushed, request, 0);
+    }
+
+    // The dumper blocks on a small socket buffer until the first bytes are read
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+    args = (dumpArgs_t){.cache = &shared, .fd = fds[1]};
+    pthread_create(&dumper, NULL, test_dumper, &args);
+    dumped += read(fds[0], contents, 4096);
+
+    store_release(shared, flushed);
+    while ((size = read(fds[0], contents + dumped, (1 << 20) - 1 - dumped)) > 0)
+        dumped += size;
+    pthread_join(dumper, NULL);
+
+    // Only the chunk formatted before the flush is sent, far from the 100 long requests,
+    // and nothing of the cache that replaced it
+    test_check(args.written);
+    test_check(dumped > 0 && dumped < 25 * MAXREQUESTSIZE);
+    test_check(strstr(contents, "Request: 'flushed:") == NULL);
+
+    close(fds[0]);
+    free(contents);
+    lru_cache_drain_recency(flushed);
+    test_free(cache);
+    test_free(flushed);
+}
+
+// A dump into a socket whose reader has hung up fails
+static void test_hung_up()
+{
+    lruCache_t  *cache = test_dump_cache();
+    int         fds[2];
+
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    close(fds[0]);
+    test_check(!cache_dump(&cache, fds[1]));
+
+    close(fds[1]);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_lines();
+    test_flushed();
+    test_hung_up();
+    epoch_free_all();
+
+    return test_result();
+}
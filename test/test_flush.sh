@@ -0,0 +1,87 @@
+#!/bin/bash
+
+# Flush of the cache with SIGUSR1: the elements are dropped, and the new cache serves them again.
+# A cache that can't be allocated stops the server on startup, and keeps the old one on a flush.
+# Run from the root of the repository by 'make check', against a built server.
+
+PORT=$((20000 + RANDOM % 20000))
+LOG=$(mktemp)
+FAILURES=0
+
+request() {
+  exec 3<>/dev/tcp/127.0.0.1/$PORT || return 1
+  printf '%s\n' "$1" >&3
+  timeout 5 cat <&3
+  exec 3<&-
+}
+
+check() {
+  if ! eval "$1"; then
+    echo "$0: Check failed: '$1'." >&2
+    FAILURES=$((FAILURES + 1))
+  fi
+}
+
+elements() {
+  request "stats" | awk '$1 == "elements" {print $2}'
+}
+
+start() {
+  ./meteoserver -p $PORT "$@" > $LOG 2>&1 &
+  SERVER=$!
+  for i in {1..50}; do request "stats" > /dev/null 2>&1 && break; sleep 0.1; done
+}
+
+stop() {
+  kill -TERM $SERVER
+  request "stats" > /dev/null 2>&1
+  for i in {1..50}; do kill -0 $SERVER 2> /dev/null || break; sleep 0.1; done
+  kill -KILL $SERVER 2> /dev/null
+  wait $SERVER
+}
+
+start -C 100
+
+# The elements are cached with their digests
+for id in {1..20}; do
+  check "[ \"\$(request 'get flush$id 0')\" == \"$(printf 'flush%s' $id | md5sum | cut -d' ' -f1)\" ]"
+done
+check "[ \"\$(elements)\" == 20 ]"
+
+# The flush is done in the background by the maintainer
+kill -USR1 $SERVER
+for i in {1..50}; do [ "$(elements)" == 0 ] && break; sleep 0.1; done
+check "[ \"\$(elements)\" == 0 ]"
+
+check "[ \"\$(request 'get flush1 0')\" == \"$(printf 'flush1' | md5sum | cut -d' ' -f1)\" ]"
+check "[ \"\$(elements)\" == 1 ]"
+
+# The server stops on its own after SIGTERM
+stop
+check "[ $? == 0 ]"
+
+# Without memory for the cache, the server fails on startup
+(ulimit -v 200000; ./meteoserver -p $PORT -C 100000000 -S 1 > $LOG 2>&1)
+check "[ $? == 1 ]"
+check "grep -q \"Can't reserve the memory of the cache\" $LOG"
+
+# With room for a single cache, a flush fails and the server keeps serving the old one
+start -C 4000000 -S 1
+SIZE=$(awk '$1 == "VmSize:" {print $2}' /proc/$SERVER/status)
+stop
+(ulimit -v $((SIZE + 512 * 1024)); exec ./meteoserver -p $PORT -C 4000000 -S 1 > $LOG 2>&1) &
+SERVER=$!
+for i in {1..50}; do request "stats" > /dev/null 2>&1 && break; sleep 0.1; done
+check "[ \"\$(request 'get kept 0')\" == \"$(printf 'kept' | md5sum | cut -d' ' -f1)\" ]"
+kill -USR1 $SERVER
+for i in {1..50}; do grep -q "Can't allocate the flushed cache" $LOG && break; sleep 0.1; done
+check "grep -q \"Can't allocate the flushed cache\" $LOG"
+check "[ \"\$(elements)\" == 1 ]"
+kill -USR1 $SERVER
+sleep 0.5
+check "[ \"\$(elements)\" == 1 ]"
+stop
+check "[ $? == 0 ]"
+rm -f $LOG
+
+if [ $FAILURES == 0 ]; then echo "$0: OK"; else echo "$0: FAILED"; exit 1; fi
@@ -0,0 +1,154 @@
+/*
+ * [meteoserver]
+ * test_hash.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the stored hashes: requests are hashed once by the caller and the cache keeps that
+ * hash and the length of each request, which have to match before any request is compared,
+ * so requests sharing both are still told apart by their contents.
+ */
+
+
+/**
+* @brief The hash of a request is its 64-bit FNV-1a.
+*/
+static void test_fnv();
+
+/**
+* @brief Nodes keep the hash they were inserted with and the length of their request.
+*/
+static void test_stored();
+
+/**
+* @brief The hash given by the caller is the one looked up, not the hash of the request.
+*/
+static void test_caller_hash();
+
+/**
+* @brief Requests sharing their hash are told apart by their length, then by their contents.
+*/
+static void test_fingerprint();
+
+/**
+* @brief Fills a buffer with a long request whose last character is given.
+* @param request Buffer of the request.
+* @param length Length of the request.
+* @param last Last character of the request.
+* @return The request.
+*/
+static char *test_long_request(char *request, size_t length, char last);
+
+
+
+/* Definitions */
+
+
+// Fills a buffer with a long request whose last character is given
+static char *test_long_request(char *request, size_t length, char last)
+{
+    memset(request, 'h', length - 1);
+    request[length - 1] = last;
+    request[length] = '\0';
+    return request;
+}
+
+// The hash of a request is its 64-bit FNV-1a
+static void test_fnv()
+{
+    test_check(lru_hash_request("") == 0xcbf29ce484222325ULL);
+    test_check(lru_hash_request("a") == 0xaf63dc4c8601ec8cULL);
+    test_check(lru_hash_request("foobar") == 0x85944171f73967e8ULL);
+}
+
+// Nodes keep the hash they were inserted with and the length of their request
+static void test_stored()
+{
+    lruCache_t      *cache = test_cache(1, 1, &lruPolicy, false);
+    lruCacheNode_t  *node = &(cache->shards[0].cachePool[CACHE_NIL + 1]);
+    char            request[MAXREQUESTSIZE + 1];
+
+    test_insert(cache, "stored", 0);
+    test_check(node->hash == lru_hash_request("stored") && node->requestLength == strlen("stored"));
+
+    test_insert(cache, test_long_request(request, MAXREQUESTSIZE, 'x'), 0);
+    test_check(node->hash == lru_hash_request(request) && node->requestLength == MAXREQUESTSIZE);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// The hash given by the caller is the one looked up, not the hash of the request
+static void test_caller_hash()
+{
+    lruCache_t  *cache = test_cache(16, 1, &lruPolicy, false);
+    uint8_t     md5[MD5_DIGEST_SIZE];
+
+    md5Digest("caller", md5);
+    test_check(lru_cache_update_node(cache, "caller", 7, md5, 0, NULL));
+    test_check(cache->shards[0].cachePool[CACHE_NIL + 1].hash == 7);
+    test_check(lru_cache_get_element(cache, "caller", 7, md5, NULL));
+    test_check(!test_cached(cache, "caller"));
+
+    // The request is cached again under its own hash
+    test_check(test_insert(cache, "caller", 0) && test_cached(cache, "caller"));
+    test_check(cache->shards[0].currentCapacity == 2);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Requests sharing their hash are told apart by their length, then by their contents
+static void test_fingerprint()
+{
+    lruCache_t  *cache = test_cache(16, 1, &lruPolicy, false);
+    char        request[MAXREQUESTSIZE + 1];
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    // A request and its prefix
+    md5Digest("prefix", md5);
+    test_check(lru_cache_update_node(cache, "prefix", 42, md5, 0, NULL));
+    test_check(!lru_cache_get_element(cache, "prefi", 42, found, NULL));
+    test_check(!lru_cache_get_element(cache, "prefix:", 42, found, NULL));
+
+    // Long requests of the same length that only differ in their last character
+    md5Digest(test_long_request(request, MAXREQUESTSIZE, 'a'), md5);
+    test_check(lru_cache_update_node(cache, request, 42, md5, 0, NULL));
+    md5Digest(test_long_request(request, MAXREQUESTSIZE, 'b'), md5);
+    test_check(lru_cache_update_node(cache, request, 42, md5, 0, NULL));
+
+    test_check(lru_cache_get_element(cache, request, 42, found, NULL) && !memcmp(found, md5, MD5_DIGEST_SIZE));
+    md5Digest(test_long_request(request, MAXREQUESTSIZE, 'a'), md5);
+    test_check(lru_cache_get_element(cache, request, 42, found, NULL) && !memcmp(found, md5, MD5_DIGEST_SIZE));
+    test_check(!lru_cache_get_element(cache, test_long_request(request, MAXREQUESTSIZE, 'c'), 42, found, NULL));
+    test_check(cache->shards[0].currentCapacity == 3);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_fnv();
+    test_stored();
+    test_caller_hash();
+    test_fingerprint();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,200 @@
+/*
+ * [meteoserver]
+ * test_hitters.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the heavy hitters: the requests counted by each thread reach the global summary at
+ * the latest when the thread exits, the top keys are listed from the most requested one, and
+ * their counts overestimate the real ones by no more than their error.
+ */
+
+
+/* Arguments of the threads that feed the tracker */
+typedef struct          hittersArgs
+{
+    heavyHitters_t      *table;
+    int                 thread;
+    bool                cold;
+}                       hittersArgs_t;
+
+
+/**
+* @brief A few requests are counted exactly, and listed from the most to the least requested one.
+*/
+static void test_exact();
+
+/**
+* @brief The hottest requests of several threads stand out among many requested once.
+*/
+static void test_skewed();
+
+/**
+* @brief No more keys are listed than asked for or tracked, and the caller owns their requests.
+*/
+static void test_top_size();
+
+/**
+* @brief Requests 'hot:i' 1000 - 200 * i times for i in [0, 5), interleaved with requests seen once.
+* @param args Arguments of the thread.
+*/
+static void *test_worker(void *args);
+
+/**
+* @brief Runs threads feeding a tracker until all of them have exited.
+* @param table Tracker to feed.
+* @param threads Number of threads.
+* @param cold Whether the threads also request keys seen once.
+*/
+static void test_feed(heavyHitters_t *table, int threads, bool cold);
+
+/**
+* @brief Frees the requests of the listed keys.
+* @param top Listed keys.
+* @param count Number of keys.
+*/
+static void test_free_top(heavyHitter_t *top, size_t count);
+
+
+
+/* Definitions */
+
+
+// Requests 'hot:i' 1000 - 200 * i times, interleaved with requests seen once
+static void *test_worker(void *arg)
+{
+    hittersArgs_t   *args = (hittersArgs_t *)arg;
+    char            request[64];
+
+    for (int round = 0; round < 1000; round++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            if (round >= 1000 - 200 * i)
+                continue;
+            snprintf(request, sizeof(request), "hot:%d", i);
+            heavy_hitters_record(args->table, request, lru_hash_request(request));
+        }
+        for (int i = 0; args->cold && i < 2; i++)
+        {
+            snprintf(request, sizeof(request), "cold:%d:%d:%d", args->thread, round, i);
+            heavy_hitters_record(args->table, request, lru_hash_request(request));
+        }
+    }
+
+    // The summary of the thread is merged as it exits
+    return NULL;
+}
+
+// Runs threads feeding a tracker until all of them have exited
+static void test_feed(heavyHitters_t *table, int threads, bool cold)
+{
+    hittersArgs_t   args[8];
+    pthread_t       workers[8];
+
+    for (int i = 0; i < threads; i++)
+    {
+        args[i] = (hittersArgs_t){.table = table, .thread = i, .cold = cold};
+        pthread_create(&(workers[i]), NULL, test_worker, &(args[i]));
+    }
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+}
+
+// Frees the requests of the listed keys
+static void test_free_top(heavyHitter_t *top, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        free(top[i].request);
+}
+
+// A few requests are counted exactly, and listed from the most to the least requested one
+static void test_exact()
+{
+    heavyHitters_t  *table = heavy_hitters_init();
+    heavyHitter_t   top[HEAVY_HITTERS_SIZE];
+    char            request[16];
+    size_t          count;
+
+    test_feed(table, 1, false);
+    count = heavy_hitters_top(table, top, HEAVY_HITTERS_DEFAULT_K);
+    test_check(count == 5);
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(request, sizeof(request), "hot:%zu", i);
+        test_check(!strcmp(top[i].request, request) && top[i].hash == lru_hash_request(request));
+        test_check(top[i].count == 1000 - 200 * i && top[i].error == 0);
+    }
+
+    test_free_top(top, count);
+    heavy_hitters_free(table);
+}
+
+// The hottest requests of several threads stand out among many requested once
+static void test_skewed()
+{
+    heavyHitters_t  *table = heavy_hitters_init();
+    heavyHitter_t   top[HEAVY_HITTERS_SIZE];
+    char            request[16];
+    size_t          count;
+    uint64_t        real;
+
+    test_feed(table, 8, true);
+    count = heavy_hitters_top(table, top, 5);
+    test_check(count == 5);
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(request, sizeof(request), "hot:%zu", i);
+        real = 8 * (1000 - 200 * i);
+        test_check(!strcmp(top[i].request, request));
+        test_check(top[i].count >= real && top[i].count - top[i].error <= real);
+    }
+
+    test_free_top(top, count);
+    heavy_hitters_free(table);
+}
+
+// No more keys are listed than asked for or tracked, and the caller owns their requests
+static void test_top_size()
+{
+    heavyHitters_t  *table = heavy_hitters_init();
+    heavyHitter_t   top[HEAVY_HITTERS_SIZE];
+    size_t          count;
+
+    test_check(heavy_hitters_top(table, top, HEAVY_HITTERS_DEFAULT_K) == 0);
+    test_feed(table, 8, true);
+    test_check(heavy_hitters_top(table, top, 0) == 0);
+    test_check((count = heavy_hitters_top(table, top, 2)) == 2);
+    test_free_top(top, count);
+    test_check((count = heavy_hitters_top(table, top, 2 * HEAVY_HITTERS_SIZE)) == HEAVY_HITTERS_SIZE);
+    for (size_t i = 1; i < count; i++)
+        test_check(top[i - 1].count >= top[i].count);
+
+    // The listed requests outlive the tracker
+    heavy_hitters_free(table);
+    test_check(!strcmp(top[0].request, "hot:0"));
+    test_free_top(top, count);
+}
+
+
+/* main */
+
+int main()
+{
+    test_exact();
+    test_skewed();
+    test_top_size();
+
+    return test_result();
+}
@@ -0,0 +1,190 @@
+/*
+ * [meteoserver]
+ * test_index.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the hash index of the cache: every cached element is found through its bucket no
+ * matter how big the cache is, requests sharing a bucket are told apart, and evicting any of
+ * them unlinks it without losing the rest of its chain.
+ */
+
+
+/**
+* @brief Every element of a large cache is found, and requests never inserted miss.
+*/
+static void test_lookups();
+
+/**
+* @brief Requests with the same hash share a bucket, and each one is found with its own digest.
+*/
+static void test_collisions();
+
+/**
+* @brief Evicting the head, the middle or the tail of a chain keeps the rest of it reachable.
+*/
+static void test_chain_removal();
+
+/**
+* @brief Inserts a request with a given hash, instead of the one of the request.
+* @param cache Cache to insert the request into.
+* @param request Request to insert.
+* @param hash Hash to insert the request with.
+* @return Whether the cache took the request.
+*/
+static bool test_insert_hash(lruCache_t *cache, char *request, uint64_t hash);
+
+/**
+* @brief Checks whether a request is cached under a given hash, with its digest.
+* @param cache Cache to search.
+* @param request Request to search for.
+* @param hash Hash to search the request with.
+* @return Whether the request was found with its digest.
+*/
+static bool test_cached_hash(lruCache_t *cache, char *request, uint64_t hash);
+
+
+
+/* Definitions */
+
+
+// Inserts a request with a given hash, instead of the one of the request
+static bool test_insert_hash(lruCache_t *cache, char *request, uint64_t hash)
+{
+    uint8_t md5[MD5_DIGEST_SIZE];
+
+    md5Digest(request, md5);
+    return lru_cache_update_node(cache, request, hash, md5, 0, NULL);
+}
+
+// Checks whether a request is cached under a given hash, with its digest
+static bool test_cached_hash(lruCache_t *cache, char *request, uint64_t hash)
+{
+    uint8_t md5[MD5_DIGEST_SIZE];
+    uint8_t expected[MD5_DIGEST_SIZE];
+
+    md5Digest(request, expected);
+    return lru_cache_get_element(cache, request, hash, md5, NULL) && !memcmp(md5, expected, MD5_DIGEST_SIZE);
+}
+
+// Every element of a large cache is found, and requests never inserted miss
+static void test_lookups()
+{
+    lruCache_t  *cache = test_cache(100000, 1, &lruPolicy, false);
+    char        request[64];
+    bool        inserted = true;
+    bool        found = true;
+    bool        missed = true;
+
+    // The index has at least one bucket per node
+    test_check(cache->shards[0].hashMask + 1 >= cache->shards[0].poolCapacity);
+
+    for (int i = 0; i < 100000; i++)
+    {
+        snprintf(request, sizeof(request), "index:%d", i);
+        inserted &= test_insert(cache, request, 0);
+    }
+    for (int i = 0; i < 100000; i++)
+    {
+        snprintf(request, sizeof(request), "index:%d", i);
+        found &= test_cached(cache, request);
+        snprintf(request, sizeof(request), "missing:%d", i);
+        missed &= !test_cached(cache, request);
+    }
+    test_check(inserted);
+    test_check(found);
+    test_check(missed);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Requests with the same hash share a bucket, and each one is found with its own digest
+static void test_collisions()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    char        request[64];
+    bool        found = true;
+
+    for (int i = 0; i < 32; i++)
+    {
+        snprintf(request, sizeof(request), "collision:%d", i);
+        test_check(test_insert_hash(cache, request, 42));
+    }
+    for (int i = 0; i < 32; i++)
+    {
+        snprintf(request, sizeof(request), "collision:%d", i);
+        found &= test_cached_hash(cache, request, 42);
+    }
+    test_check(found);
+
+    // A request of the chain isn't found under another hash, nor another request under its hash
+    test_check(!test_cached_hash(cache, "collision:0", 43));
+    test_check(!test_cached_hash(cache, "collision:32", 42));
+
+    // Inserting a request of the chain again doesn't duplicate it
+    test_check(!test_insert_hash(cache, "collision:7", 42));
+    test_check(cache->shards[0].currentCapacity == 32);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Evicting the head, the middle or the tail of a chain keeps the rest of it reachable
+static void test_chain_removal()
+{
+    lruCache_t  *cache = test_cache(4, 1, &lruPolicy, false);
+
+    // The chain of the bucket is d -> c -> b -> a, and the least recently used is a
+    test_insert_hash(cache, "a", 42);
+    test_insert_hash(cache, "b", 42);
+    test_insert_hash(cache, "c", 42);
+    test_insert_hash(cache, "d", 42);
+
+    // The tail of the chain is evicted
+    test_check(test_insert_hash(cache, "e", 42));
+    test_check(!test_cached_hash(cache, "a", 42));
+
+    // Hitting b and e leaves c, in the middle of the chain e -> d -> c -> b, as the victim
+    test_check(test_cached_hash(cache, "b", 42) && test_cached_hash(cache, "e", 42));
+    lru_cache_drain_recency(cache);
+    test_check(test_insert_hash(cache, "f", 42));
+    test_check(!test_cached_hash(cache, "c", 42));
+    test_check(test_cached_hash(cache, "b", 42) && test_cached_hash(cache, "d", 42));
+
+    // Hitting every other request leaves f, the head of the chain f -> e -> d -> b, as the victim
+    test_check(test_cached_hash(cache, "e", 42));
+    lru_cache_drain_recency(cache);
+    test_check(test_insert_hash(cache, "g", 42));
+    test_check(!test_cached_hash(cache, "f", 42));
+    test_check(test_cached_hash(cache, "b", 42) && test_cached_hash(cache, "d", 42));
+    test_check(test_cached_hash(cache, "e", 42) && test_cached_hash(cache, "g", 42));
+    test_check(cache->shards[0].currentCapacity == 4);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_lookups();
+    test_collisions();
+    test_chain_removal();
+    epoch_free_all();
+
+    return test_result();
+}
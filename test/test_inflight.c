@@ -0,0 +1,234 @@
+/*
+ * [meteoserver]
+ * test_inflight.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the in-flight table: the first miss of a request leads its computation, the misses
+ * of the same request arriving meanwhile wait for the digest of the leader instead of computing
+ * it again, and a published request is led anew by its next miss.
+ */
+
+
+/* Arguments of the threads of the tests */
+typedef struct          inflightArgs
+{
+    inflightTable_t     *table;
+    char                *request;
+    bool                leader;
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    size_t              computed;
+    bool                matched;
+}                       inflightArgs_t;
+
+
+/**
+* @brief A miss with no other one in flight leads, and is led anew once published.
+*/
+static void test_leader();
+
+/**
+* @brief Requests with the same hash, or the same stripe, are only coalesced with themselves.
+*/
+static void test_distinct();
+
+/**
+* @brief Misses arriving while the leader computes wait for it, and all of them get its digest.
+*/
+static void test_followers();
+
+/**
+* @brief Threads missing the same few requests over and over always get the digest of their request.
+*/
+static void test_herd();
+
+/**
+* @brief Registers a miss, waiting for its leader if there's one.
+* @param args Arguments of the thread.
+*/
+static void *test_follower(void *args);
+
+/**
+* @brief Computes a few requests over and over, through the table.
+* @param args Arguments of the thread.
+*/
+static void *test_computer(void *args);
+
+
+
+/* Definitions */
+
+
+// A miss with no other one in flight leads, and is led anew once published
+static void test_leader()
+{
+    inflightTable_t *table = inflight_table_init();
+    inflightEntry_t *entry;
+    uint8_t         md5[MD5_DIGEST_SIZE];
+
+    md5Digest("leader", md5);
+    entry = inflight_table_acquire(table, "leader", lru_hash_request("leader"), md5);
+    test_check(entry != NULL && entry->waiters == 0 && !entry->done);
+    inflight_table_publish(table, entry, md5);
+
+    entry = inflight_table_acquire(table, "leader", lru_hash_request("leader"), md5);
+    test_check(entry != NULL);
+    inflight_table_publish(table, entry, md5);
+
+    for (size_t i = 0; i < INFLIGHT_TABLE_STRIPES; i++)
+        test_check(table->stripes[i].entries == NULL);
+    inflight_table_free(table);
+}
+
+// Requests with the same hash, or the same stripe, are only coalesced with themselves
+static void test_distinct()
+{
+    inflightTable_t *table = inflight_table_init();
+    inflightEntry_t *first;
+    inflightEntry_t *second;
+    inflightEntry_t *third;
+    uint8_t         md5[MD5_DIGEST_SIZE] = {0};
+
+    first = inflight_table_acquire(table, "first", 42, md5);
+    second = inflight_table_acquire(table, "second", 42, md5);
+    third = inflight_table_acquire(table, "third", 42 + INFLIGHT_TABLE_STRIPES, md5);
+    test_check(first && second && third && first != second && second != third);
+
+    // Publishing any of them leaves the others registered
+    inflight_table_publish(table, second, md5);
+    test_check(table->stripes[42].entries == third && third->next == first && first->next == NULL);
+    inflight_table_publish(table, first, md5);
+    inflight_table_publish(table, third, md5);
+    test_check(table->stripes[42].entries == NULL);
+
+    inflight_table_free(table);
+}
+
+// Registers a miss, waiting for its leader if there's one
+static void *test_follower(void *arg)
+{
+    inflightArgs_t  *args = (inflightArgs_t *)arg;
+    inflightEntry_t *entry;
+
+    entry = inflight_table_acquire(args->table, args->request, lru_hash_request(args->request), args->md5);
+    args->leader = entry != NULL;
+    if (entry)
+        inflight_table_publish(args->table, entry, args->md5);
+
+    return NULL;
+}
+
+// Misses arriving while the leader computes wait for it, and all of them get its digest
+static void test_followers()
+{
+    inflightTable_t     *table = inflight_table_init();
+    inflightStripe_t    *stripe = &(table->stripes[lru_hash_request("herd") & (INFLIGHT_TABLE_STRIPES - 1)]);
+    inflightEntry_t     *entry;
+    inflightArgs_t      args[16];
+    pthread_t           followers[16];
+    uint8_t             md5[MD5_DIGEST_SIZE];
+    unsigned int        waiters = 0;
+
+    md5Digest("herd", md5);
+    entry = inflight_table_acquire(table, "herd", lru_hash_request("herd"), md5);
+    test_check(entry != NULL);
+    for (int i = 0; i < 16; i++)
+    {
+        args[i] = (inflightArgs_t){.table = table, .request = "herd"};
+        pthread_create(&(followers[i]), NULL, test_follower, &(args[i]));
+    }
+
+    // The digest is only published once every follower waits for it
+    while (waiters < 16)
+    {
+        usleep(1000);
+        pthread_mutex_lock(&(stripe->mutex));
+        waiters = entry->waiters;
+        pthread_mutex_unlock(&(stripe->mutex));
+    }
+    inflight_table_publish(table, entry, md5);
+
+    for (int i = 0; i < 16; i++)
+    {
+        pthread_join(followers[i], NULL);
+        test_check(!args[i].leader && !memcmp(args[i].md5, md5, MD5_DIGEST_SIZE));
+    }
+    test_check(stripe->entries == NULL);
+    inflight_table_free(table);
+}
+
+// Computes a few requests over and over, through the table
+static void *test_computer(void *arg)
+{
+    inflightArgs_t  *args = (inflightArgs_t *)arg;
+    inflightEntry_t *entry;
+    char            request[32];
+    uint8_t         md5[MD5_DIGEST_SIZE];
+    uint8_t         expected[MD5_DIGEST_SIZE];
+
+    args->matched = true;
+    for (int i = 0; i < 2000; i++)
+    {
+        snprintf(request, sizeof(request), "herd:%d", i % 4);
+        md5Digest(request, expected);
+        if ((entry = inflight_table_acquire(args->table, request, lru_hash_request(request), md5)))
+        {
+            args->computed++;
+            memcpy(md5, expected, MD5_DIGEST_SIZE);
+            inflight_table_publish(args->table, entry, md5);
+        }
+        args->matched &= !memcmp(md5, expected, MD5_DIGEST_SIZE);
+    }
+
+    return NULL;
+}
+
+// Threads missing the same few requests over and over always get the digest of their request
+static void test_herd()
+{
+    inflightTable_t *table = inflight_table_init();
+    inflightArgs_t  args[8];
+    pthread_t       computers[8];
+    size_t          computed = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        args[i] = (inflightArgs_t){.table = table};
+        pthread_create(&(computers[i]), NULL, test_computer, &(args[i]));
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        pthread_join(computers[i], NULL);
+        test_check(args[i].matched);
+        computed += args[i].computed;
+    }
+
+    test_check(computed > 0 && computed <= 8 * 2000);
+    for (size_t i = 0; i < INFLIGHT_TABLE_STRIPES; i++)
+        test_check(table->stripes[i].entries == NULL);
+    inflight_table_free(table);
+}
+
+
+/* main */
+
+int main()
+{
+    test_leader();
+    test_distinct();
+    test_followers();
+    test_herd();
+
+    return test_result();
+}
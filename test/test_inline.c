@@ -0,0 +1,157 @@
+/*
+ * [meteoserver]
+ * test_inline.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the requests stored inline: requests shorter than CACHE_INLINE_KEY_SIZE are kept in
+ * the buffer of their node and the rest are allocated, nodes switch between both as they're
+ * reused, and the stored length tells requests sharing a prefix apart.
+ */
+
+
+/**
+* @brief Requests up to CACHE_INLINE_KEY_SIZE - 1 characters are stored inline, longer ones allocated.
+*/
+static void test_boundary();
+
+/**
+* @brief A node reused for a short request after a long one, and the other way round, keeps its request.
+*/
+static void test_reuse();
+
+/**
+* @brief Requests sharing the inline prefix, or differing only in their length, are told apart.
+*/
+static void test_prefixes();
+
+/**
+* @brief Returns the data of the only node of a one-element cache.
+* @param cache Cache of a single element.
+* @return Data of the node.
+*/
+static lruCacheNodeData_t *test_node_data(lruCache_t *cache);
+
+/**
+* @brief Fills a buffer with a request of a given length.
+* @param request Buffer of the request.
+* @param fill Character the request is made of.
+* @param length Length of the request.
+* @return The request.
+*/
+static char *test_request(char *request, char fill, size_t length);
+
+
+
+/* Definitions */
+
+
+// Returns the data of the only node of a one-element cache
+static lruCacheNodeData_t *test_node_data(lruCache_t *cache)
+{
+    return &(cache->shards[0].nodeData[CACHE_NIL + 1]);
+}
+
+// Fills a buffer with a request of a given length
+static char *test_request(char *request, char fill, size_t length)
+{
+    memset(request, fill, length);
+    request[length] = '\0';
+    return request;
+}
+
+// Requests up to CACHE_INLINE_KEY_SIZE - 1 characters are stored inline, longer ones allocated
+static void test_boundary()
+{
+    lruCache_t          *cache = test_cache(1, 1, &lruPolicy, false);
+    lruCacheNodeData_t  *data = test_node_data(cache);
+    char                request[64];
+
+    test_insert(cache, test_request(request, 'a', CACHE_INLINE_KEY_SIZE - 1), 0);
+    test_check(data->request == data->inlineRequest && !strcmp(data->request, request));
+    test_check(cache->shards[0].cachePool[CACHE_NIL + 1].requestLength == CACHE_INLINE_KEY_SIZE - 1);
+    test_check(test_cached(cache, request));
+
+    test_insert(cache, test_request(request, 'b', CACHE_INLINE_KEY_SIZE), 0);
+    test_check(data->request != data->inlineRequest && !strcmp(data->request, request));
+    test_check(cache->shards[0].cachePool[CACHE_NIL + 1].requestLength == CACHE_INLINE_KEY_SIZE);
+    test_check(test_cached(cache, request));
+
+    // The empty request is stored inline too
+    test_insert(cache, "", 0);
+    test_check(data->request == data->inlineRequest && data->request[0] == '\0');
+    test_check(test_cached(cache, ""));
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// A node reused for a short request after a long one, and the other way round, keeps its request
+static void test_reuse()
+{
+    lruCache_t          *cache = test_cache(1, 1, &lruPolicy, false);
+    lruCacheNodeData_t  *data = test_node_data(cache);
+    char                request[MAXREQUESTSIZE + 1];
+    bool                kept = true;
+
+    for (int i = 0; i < 64; i++)
+    {
+        test_request(request, 'a' + i % 26, i % 2 ? MAXREQUESTSIZE : i % CACHE_INLINE_KEY_SIZE);
+        test_check(test_insert(cache, request, 0));
+        kept &= (data->request == data->inlineRequest) == (i % 2 == 0);
+        kept &= !strcmp(data->request, request) && test_cached(cache, request);
+        lru_cache_drain_recency(cache);
+    }
+    test_check(kept);
+    test_check(cache->shards[0].poolUsed == CACHE_NIL + 2);
+
+    test_free(cache);
+}
+
+// Requests sharing the inline prefix, or differing only in their length, are told apart
+static void test_prefixes()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    char        request[64];
+    bool        found = true;
+
+    for (size_t length = 1; length < 48; length++)
+        test_insert(cache, test_request(request, 'p', length), 0);
+    for (size_t length = 1; length < 48; length++)
+        found &= test_cached(cache, test_request(request, 'p', length));
+    test_check(found);
+    test_check(!test_cached(cache, test_request(request, 'p', 48)));
+
+    // Only the last character differs
+    test_request(request, 'p', 40);
+    request[39] = 'q';
+    test_check(!test_cached(cache, request));
+    test_check(test_insert(cache, request, 0) && test_cached(cache, request));
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_boundary();
+    test_reuse();
+    test_prefixes();
+    epoch_free_all();
+
+    return test_result();
+}
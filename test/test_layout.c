@@ -0,0 +1,159 @@
+/*
+ * [meteoserver]
+ * test_layout.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the layout of the cache: the hot metadata of two nodes shares a cache line and the
+ * cold data of each one fills a line of its own, both arrays are aligned to cache lines, and
+ * nodes are taken from the pool in order, their links being indices within it.
+ */
+
+
+/**
+* @brief Nodes take half a cache line, their data a whole one, and their links 32 bits.
+*/
+static void test_sizes();
+
+/**
+* @brief The shards and the arrays of each shard start at the beginning of a cache line.
+*/
+static void test_alignment();
+
+/**
+* @brief Nodes are taken from the pool in order, and every link is an index of a used node.
+*/
+static void test_contiguous();
+
+/**
+* @brief Evicted nodes are reused before the pool grows.
+*/
+static void test_free_list();
+
+
+
+/* Definitions */
+
+
+// Nodes take half a cache line, their data a whole one, and their links 32 bits
+static void test_sizes()
+{
+    lruCacheNode_t node;
+
+    test_check(sizeof(lruCacheNode_t) == CACHE_LINE_SIZE / 2);
+    test_check(sizeof(lruCacheNodeData_t) == CACHE_LINE_SIZE);
+    test_check(sizeof(node.next) == sizeof(uint32_t) && sizeof(node.prev) == sizeof(uint32_t));
+    test_check(sizeof(node.hashNext) == sizeof(uint32_t));
+}
+
+// The shards and the arrays of each shard start at the beginning of a cache line
+static void test_alignment()
+{
+    lruCache_t *cache = test_cache(1000, 7, &lruPolicy, false);
+
+    for (size_t i = 0; i < cache->shardNumber; i++)
+    {
+        test_check((uintptr_t)&(cache->shards[i]) % CACHE_LINE_SIZE == 0);
+        test_check((uintptr_t)cache->shards[i].cachePool % CACHE_LINE_SIZE == 0);
+        test_check((uintptr_t)cache->shards[i].nodeData % CACHE_LINE_SIZE == 0);
+        test_check((uintptr_t)cache->shards[i].hashTable % CACHE_LINE_SIZE == 0);
+    }
+
+    test_free(cache);
+}
+
+// Nodes are taken from the pool in order, and every link is an index of a used node
+static void test_contiguous()
+{
+    lruCache_t      *cache = test_cache(256, 1, &lruPolicy, false);
+    lruCacheShard_t *shard = &(cache->shards[0]);
+    lruCacheNode_t  *node;
+    char            request[32];
+    bool            linked = true;
+    size_t          listed = 0;
+
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(request, sizeof(request), "layout:%d", i);
+        test_insert(cache, request, 0);
+        test_check(shard->poolUsed == CACHE_NIL + 2 + (size_t)i);
+        test_check(!strcmp(shard->nodeData[CACHE_NIL + 1 + i].request, request));
+    }
+    test_check(!shard->cachePool[CACHE_NIL].used);
+
+    // Every link points to a node of the used part of the pool
+    for (size_t i = CACHE_NIL + 1; i < shard->poolUsed; i++)
+    {
+        node = cache_node(shard, i);
+        linked &= node->used && cache_node_index(shard, node) == i;
+        linked &= node->next < shard->poolUsed && node->prev < shard->poolUsed && node->hashNext < shard->poolUsed;
+    }
+    test_check(linked);
+
+    // The queues of the policy go through every node
+    for (node = cache_queue_next(shard, NULL); node && listed <= 200; node = cache_queue_next(shard, node))
+        listed++;
+    test_check(listed == 200);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Evicted nodes are reused before the pool grows
+static void test_free_list()
+{
+    lruCache_t      *cache = test_cache(64, 1, &lruPolicy, false);
+    lruCacheShard_t *shard = &(cache->shards[0]);
+    char            request[32];
+
+    for (int i = 0; i < 64; i++)
+    {
+        snprintf(request, sizeof(request), "layout:%d", i);
+        test_insert(cache, request, 0);
+    }
+
+    // Shrinking the cache frees 48 nodes, which take the next 48 requests
+    lru_cache_resize(cache, 16, 0);
+    while (lru_cache_trim(cache));
+    test_check(shard->freeNodes != CACHE_NIL && shard->currentCapacity == 16);
+    lru_cache_resize(cache, 64, 0);
+    for (int i = 64; i < 112; i++)
+    {
+        snprintf(request, sizeof(request), "layout:%d", i);
+        test_check(test_insert(cache, request, 0));
+    }
+    test_check(shard->freeNodes == CACHE_NIL && shard->poolUsed == CACHE_NIL + 65);
+    test_check(shard->currentCapacity == 64);
+
+    // Once full, every new request recycles the node of its victim
+    test_check(test_insert(cache, "layout:recycled", 0) && test_cached(cache, "layout:recycled"));
+    test_check(shard->poolUsed == CACHE_NIL + 65);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_sizes();
+    test_alignment();
+    test_contiguous();
+    test_free_list();
+    epoch_free_all();
+
+    return test_result();
+}
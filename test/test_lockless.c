@@ -0,0 +1,143 @@
+/*
+ * [meteoserver]
+ * test_lockless.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the lock-free read path of the cache: hits are served while the shard lock is
+ * taken, and lookups racing with the inserts that evict and recycle their nodes never return
+ * the digest of another request.
+ */
+
+
+/* Arguments of the threads of the concurrent test */
+typedef struct          locklessArgs
+{
+    lruCache_t          *cache;
+    unsigned int        seed;
+    bool                writer;
+    size_t              hits;
+    size_t              torn;
+}                       locklessArgs_t;
+
+
+/**
+* @brief Hits are served, and misses reported, while another thread holds the lock of the shard.
+*/
+static void test_locked_shard();
+
+/**
+* @brief Lookups racing with inserts that recycle their nodes only return the digest of their request.
+*/
+static void test_recycled_nodes();
+
+/**
+* @brief Looks up or inserts random requests, out of twice as many as the cache holds.
+* @param args Arguments of the thread.
+*/
+static void *test_worker(void *args);
+
+
+
+/* Definitions */
+
+
+// Hits are served, and misses reported, while another thread holds the lock of the shard
+static void test_locked_shard()
+{
+    lruCache_t *cache = test_cache(4, 1, &lruPolicy, false);
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+
+    // A lookup taking the lock would never return
+    pthread_mutex_lock(&(cache->shards[0].mutex));
+    for (int i = 0; i < 2 * RECENCY_BUFFER_SIZE; i++)
+        test_check(test_cached(cache, "a") && !test_cached(cache, "c"));
+    pthread_mutex_unlock(&(cache->shards[0].mutex));
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Looks up or inserts random requests, out of twice as many as the cache holds
+static void *test_worker(void *arg)
+{
+    locklessArgs_t  *args = (locklessArgs_t *)arg;
+    char            request[64];
+    uint8_t         md5[MD5_DIGEST_SIZE];
+    uint8_t         expected[MD5_DIGEST_SIZE];
+
+    // Half of the requests are long enough to be allocated, and retired once evicted
+    for (int i = 0; i < 200000; i++)
+    {
+        snprintf(request, sizeof(request), "%s:%d", rand_r(&(args->seed)) % 2 ? "lockless" :
+                 "lockless:request:allocated:on:the:heap", rand_r(&(args->seed)) % 128);
+        if (args->writer)
+        {
+            test_insert(args->cache, request, 0);
+            continue;
+        }
+
+        md5Digest(request, expected);
+        if (lru_cache_get_element(args->cache, request, lru_hash_request(request), md5, NULL))
+        {
+            args->hits++;
+            args->torn += memcmp(md5, expected, MD5_DIGEST_SIZE) != 0;
+        }
+    }
+
+    lru_cache_drain_recency(args->cache);
+    epoch_unregister();
+    cache_stats_unregister();
+    return NULL;
+}
+
+// Lookups racing with inserts that recycle their nodes only return the digest of their request
+static void test_recycled_nodes()
+{
+    lruCache_t      *cache = test_cache(64, 1, &lruPolicy, false);
+    locklessArgs_t  args[6];
+    pthread_t       workers[6];
+    size_t          hits = 0;
+    size_t          torn = 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+        args[i] = (locklessArgs_t){.cache = cache, .seed = i + 1, .writer = i < 2};
+        pthread_create(&(workers[i]), NULL, test_worker, &(args[i]));
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        pthread_join(workers[i], NULL);
+        hits += args[i].hits;
+        torn += args[i].torn;
+    }
+
+    test_check(hits > 0);
+    test_check(torn == 0);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_locked_shard();
+    test_recycled_nodes();
+    epoch_free_all();
+
+    return test_result();
+}
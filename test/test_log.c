@@ -0,0 +1,221 @@
+/*
+ * [meteoserver]
+ * test_log.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the insert log: its records are replayed into a new cache, a full buffer drops them
+ * instead of waiting for the disk, a compaction drops the records of the snapshot and of the
+ * flushed caches, and a damaged tail is cut off.
+ */
+
+
+/**
+* @brief Every record appended is replayed, over several writes of the buffer.
+*/
+static void test_round_trip();
+
+/**
+* @brief A full buffer drops the records appended to it instead of waiting for the writer.
+*/
+static void test_full_buffer();
+
+/**
+* @brief A compaction keeps only the records appended during it, and drops the ones of older caches.
+*/
+static void test_compaction();
+
+/**
+* @brief Replaying a log with a damaged tail stops at the last valid record, and cuts the tail off.
+*/
+static void test_damaged_tail();
+
+/**
+* @brief Appends a number of records of a generation to a log.
+* @param log Insert log.
+* @param prefix Prefix of the requests.
+* @param count Number of records.
+* @param generation Generation of the cache of the records.
+*/
+static void test_append(insertLog_t *log, char *prefix, int count, uint64_t generation);
+
+
+
+/* Definitions */
+
+
+// Appends a number of records of a generation to a log
+static void test_append(insertLog_t *log, char *prefix, int count, uint64_t generation)
+{
+    char    request[MAXREQUESTSIZE];
+    uint8_t md5[MD5_DIGEST_SIZE];
+
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(request, sizeof(request), "%s:%d:%0200d", prefix, i, 0);
+        md5Digest(request, md5);
+        insert_log_append(log, request, md5, 0, generation);
+    }
+}
+
+// Every record appended is replayed, over several writes of the buffer
+static void test_round_trip()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    insertLog_t *log;
+    char        path[PATH_MAX];
+    char        prefix[16];
+    size_t      replayed;
+    size_t      size;
+    int         count = INSERT_LOG_BUFFER_SIZE / 2 / (sizeof(insertLogRecord_t) + 210);
+
+    snprintf(path, sizeof(path), "/tmp/test_log.%d", getpid());
+    unlink(path);
+
+    // Twice as many records as fit in the buffer, each half of them written before the next one
+    log = insert_log_open(path, cache, &replayed);
+    test_check(log && replayed == 0);
+    for (int i = 0; i < 4; i++)
+    {
+        size = insert_log_size(log);
+        snprintf(prefix, sizeof(prefix), "log%d", i);
+        test_append(log, prefix, count, 1);
+        while (insert_log_size(log) == size)
+            usleep(INSERT_LOG_FLUSH_MS * 1000);
+    }
+    test_check(log->dropped == 0);
+    insert_log_close(log);
+    test_free(cache);
+
+    // The smaller cache evicts most of them, freeing their requests through the epoch
+    cache = test_cache(16, 1, &lruPolicy, false);
+    log = insert_log_open(path, cache, &replayed);
+    test_check(replayed == 4 * (size_t)count);
+    test_check(epoch_thread()->retiredCount < EPOCH_RECLAIM_THRESHOLD);
+    insert_log_close(log);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    unlink(path);
+}
+
+// A full buffer drops the records appended to it instead of waiting for the writer
+static void test_full_buffer()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    insertLog_t *log;
+    char        path[PATH_MAX];
+    size_t      replayed;
+    size_t      dropped;
+    int         fit = INSERT_LOG_BUFFER_SIZE / (sizeof(insertLogRecord_t) + 210);
+
+    snprintf(path, sizeof(path), "/tmp/test_log.%d", getpid());
+    unlink(path);
+    log = insert_log_open(path, cache, &replayed);
+
+    // The writer doesn't empty the buffer during a compaction
+    insert_log_pause(log, 1);
+    test_append(log, "full", 2 * fit, 1);
+    dropped = log->dropped;
+    test_check(dropped > (size_t)fit / 2 && dropped < 2 * (size_t)fit);
+    insert_log_resume(log, false);
+    insert_log_close(log);
+
+    // Every record is either dropped or replayed
+    log = insert_log_open(path, cache, &replayed);
+    test_check(replayed == 2 * (size_t)fit - dropped);
+    insert_log_close(log);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    unlink(path);
+}
+
+// A compaction keeps only the records appended during it, and drops the ones of older caches
+static void test_compaction()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    insertLog_t *log;
+    char        path[PATH_MAX];
+    size_t      replayed;
+
+    snprintf(path, sizeof(path), "/tmp/test_log.%d", getpid());
+    unlink(path);
+    log = insert_log_open(path, cache, &replayed);
+
+    // Records of the flushed cache are still buffered when the new one is saved
+    test_append(log, "flushed", 8, 1);
+    insert_log_pause(log, 2);
+    test_append(log, "late", 4, 1);
+    test_append(log, "during", 4, 2);
+    insert_log_resume(log, true);
+    test_append(log, "after", 4, 2);
+    insert_log_close(log);
+
+    log = insert_log_open(path, cache, &replayed);
+    test_check(replayed == 8);
+
+    // A failed compaction keeps the buffered records
+    insert_log_pause(log, 3);
+    test_append(log, "kept", 4, 3);
+    insert_log_resume(log, false);
+    insert_log_close(log);
+    log = insert_log_open(path, cache, &replayed);
+    test_check(replayed == 12);
+    insert_log_close(log);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    unlink(path);
+}
+
+// Replaying a log with a damaged tail stops at the last valid record, and cuts the tail off
+static void test_damaged_tail()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    insertLog_t *log;
+    char        path[PATH_MAX];
+    struct stat info;
+    size_t      replayed;
+    int         fd;
+
+    snprintf(path, sizeof(path), "/tmp/test_log.%d", getpid());
+    unlink(path);
+    log = insert_log_open(path, cache, &replayed);
+    test_append(log, "valid", 4, 1);
+    insert_log_close(log);
+    test_check(stat(path, &info) == 0);
+
+    fd = open(path, O_WRONLY | O_APPEND);
+    test_check(fd >= 0 && write(fd, "torn record", 11) == 11);
+    close(fd);
+
+    log = insert_log_open(path, cache, &replayed);
+    test_check(replayed == 4);
+    test_check(insert_log_size(log) == (size_t)info.st_size);
+    insert_log_close(log);
+    test_free(cache);
+    unlink(path);
+}
+
+
+/* main */
+
+int main()
+{
+    test_round_trip();
+    test_full_buffer();
+    test_compaction();
+    test_damaged_tail();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,165 @@
+/*
+ * [meteoserver]
+ * test_near.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the near cache: a slot serves the digest of its request until another request takes
+ * it, the cache it was filled from is replaced or the element expires, and every
+ * NEAR_CACHE_REFRESH-th hit is sent to the shared cache so its recency isn't lost.
+ */
+
+
+/**
+* @brief A stored request is found with its digest, and requests never stored miss.
+*/
+static void test_hit();
+
+/**
+* @brief Requests mapped to the same slot replace each other.
+*/
+static void test_direct_mapped();
+
+/**
+* @brief Requests stored from a cache aren't served once that cache is replaced by another one.
+*/
+static void test_generation();
+
+/**
+* @brief Requests miss once they expire, unless they never do.
+*/
+static void test_expiry();
+
+/**
+* @brief Every NEAR_CACHE_REFRESH-th hit of a request misses.
+*/
+static void test_refresh();
+
+
+
+/* Definitions */
+
+
+// A stored request is found with its digest, and requests never stored miss
+static void test_hit()
+{
+    nearCache_t *nearCache = near_cache_init();
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    test_check((uintptr_t)nearCache % CACHE_LINE_SIZE == 0 && sizeof(nearCacheSlot_t) == CACHE_LINE_SIZE);
+
+    md5Digest("near", md5);
+    test_check(!near_cache_get(nearCache, "near", lru_hash_request("near"), 1, found));
+    near_cache_put(nearCache, "near", lru_hash_request("near"), 1, md5, 0);
+    test_check(near_cache_get(nearCache, "near", lru_hash_request("near"), 1, found));
+    test_check(!memcmp(found, md5, MD5_DIGEST_SIZE));
+
+    // The request is compared, not only its hash
+    test_check(!near_cache_get(nearCache, "other", lru_hash_request("near"), 1, found));
+
+    near_cache_free(nearCache);
+}
+
+// Requests mapped to the same slot replace each other
+static void test_direct_mapped()
+{
+    nearCache_t *nearCache = near_cache_init();
+    char        request[MAXREQUESTSIZE + 1];
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    memset(request, 'n', MAXREQUESTSIZE);
+    request[MAXREQUESTSIZE] = '\0';
+
+    near_cache_put(nearCache, request, 7, 1, md5, 0);
+    near_cache_put(nearCache, "short", 7 + NEAR_CACHE_SLOTS, 1, md5, 0);
+    near_cache_put(nearCache, "neighbour", 8, 1, md5, 0);
+    test_check(!near_cache_get(nearCache, request, 7, 1, found));
+    test_check(near_cache_get(nearCache, "short", 7 + NEAR_CACHE_SLOTS, 1, found));
+    test_check(near_cache_get(nearCache, "neighbour", 8, 1, found));
+
+    // The short request reuses the buffer of the long one
+    test_check(nearCache->slots[7].size == MAXREQUESTSIZE + 1);
+
+    near_cache_free(nearCache);
+}
+
+// Requests stored from a cache aren't served once that cache is replaced by another one
+static void test_generation()
+{
+    nearCache_t *nearCache = near_cache_init();
+    lruCache_t  *cache = test_cache(16, 1, &lruPolicy, false);
+    lruCache_t  *flushed = test_cache(16, 1, &lruPolicy, false);
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    test_check(cache->generation != flushed->generation);
+    near_cache_put(nearCache, "near", lru_hash_request("near"), cache->generation, md5, 0);
+    test_check(near_cache_get(nearCache, "near", lru_hash_request("near"), cache->generation, found));
+    test_check(!near_cache_get(nearCache, "near", lru_hash_request("near"), flushed->generation, found));
+
+    test_free(cache);
+    test_free(flushed);
+    near_cache_free(nearCache);
+}
+
+// Requests miss once they expire, unless they never do
+static void test_expiry()
+{
+    nearCache_t *nearCache = near_cache_init();
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    uint8_t     found[MD5_DIGEST_SIZE];
+
+    near_cache_put(nearCache, "expired", lru_hash_request("expired"), 1, md5, lru_clock_ms() - 1);
+    near_cache_put(nearCache, "expiring", lru_hash_request("expiring"), 1, md5, lru_clock_ms() + 60 * 1000);
+    near_cache_put(nearCache, "forever", lru_hash_request("forever"), 1, md5, 0);
+
+    test_check(!near_cache_get(nearCache, "expired", lru_hash_request("expired"), 1, found));
+    test_check(near_cache_get(nearCache, "expiring", lru_hash_request("expiring"), 1, found));
+    test_check(near_cache_get(nearCache, "forever", lru_hash_request("forever"), 1, found));
+
+    near_cache_free(nearCache);
+}
+
+// Every NEAR_CACHE_REFRESH-th hit of a request misses
+static void test_refresh()
+{
+    nearCache_t *nearCache = near_cache_init();
+    uint8_t     md5[MD5_DIGEST_SIZE] = {0};
+    uint8_t     found[MD5_DIGEST_SIZE];
+    size_t      hits = 0;
+
+    near_cache_put(nearCache, "refresh", lru_hash_request("refresh"), 1, md5, 0);
+    for (int i = 0; i < 10 * NEAR_CACHE_REFRESH; i++)
+        hits += near_cache_get(nearCache, "refresh", lru_hash_request("refresh"), 1, found);
+    test_check(hits == 10 * (NEAR_CACHE_REFRESH - 1));
+
+    near_cache_free(nearCache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_hit();
+    test_direct_mapped();
+    test_generation();
+    test_expiry();
+    test_refresh();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,164 @@
+/*
+ * [meteoserver]
+ * test_policies.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the ARC and S3-FIFO eviction policies: requests hit more than once survive a scan of
+ * one-off requests, and the ones found in a ghost list are inserted straight into the queue of
+ * the frequent ones (queue 1 of the shard for both policies).
+ */
+
+
+/**
+* @brief ARC keeps the requests of T2 while a scan goes through T1.
+*/
+static void test_arc_scan();
+
+/**
+* @brief ARC inserts a request found in B1 into T2, growing the target size of T1.
+*/
+static void test_arc_ghost();
+
+/**
+* @brief S3-FIFO promotes the hit requests of the small queue, and keeps them through a scan.
+*/
+static void test_s3fifo_scan();
+
+/**
+* @brief S3-FIFO inserts a request evicted from the small queue straight into the main one.
+*/
+static void test_s3fifo_ghost();
+
+/**
+* @brief Inserts a number of one-off requests.
+* @param cache Cache where the requests are inserted.
+* @param first Number of the first request.
+* @param count Number of requests.
+*/
+static void test_scan(lruCache_t *cache, int first, int count);
+
+
+
+/* Definitions */
+
+
+// Inserts a number of one-off requests
+static void test_scan(lruCache_t *cache, int first, int count)
+{
+    char request[32];
+
+    for (int i = first; i < first + count; i++)
+    {
+        snprintf(request, sizeof(request), "scan:%d", i);
+        test_insert(cache, request, 0);
+    }
+}
+
+// ARC keeps the requests of T2 while a scan goes through T1
+static void test_arc_scan()
+{
+    lruCache_t *cache = test_cache(4, 1, &arcPolicy, false);
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_check(test_cached(cache, "a"));
+    test_check(test_cached(cache, "b"));
+    lru_cache_drain_recency(cache);
+    test_check(cache->shards[0].queueSizes[1] == 2);
+
+    test_scan(cache, 0, 16);
+    test_check(test_cached(cache, "a"));
+    test_check(test_cached(cache, "b"));
+    test_check(!test_cached(cache, "scan:0"));
+    test_check(test_cached(cache, "scan:15"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// ARC inserts a request found in B1 into T2
+static void test_arc_ghost()
+{
+    lruCache_t  *cache = test_cache(4, 1, &arcPolicy, false);
+    arcState_t  *arc = cache->shards[0].policyData;
+
+    test_insert(cache, "a", 0);
+    test_check(test_cached(cache, "a"));
+    lru_cache_drain_recency(cache);
+
+    // 'scan:0' is evicted from T1 and remembered in B1
+    test_scan(cache, 0, 4);
+    test_check(!test_cached(cache, "scan:0"));
+    test_check(arc->target == 0);
+
+    test_insert(cache, "scan:0", 0);
+    test_check(test_cached(cache, "scan:0"));
+    test_check(cache->shards[0].queueSizes[1] == 2);
+    test_check(arc->target == 1);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// S3-FIFO promotes the hit requests of the small queue, and keeps them through a scan
+static void test_s3fifo_scan()
+{
+    lruCache_t *cache = test_cache(10, 1, &s3FifoPolicy, false);
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_check(test_cached(cache, "a"));
+    test_check(test_cached(cache, "b"));
+
+    // The first victim promotes 'a' and 'b' to the main queue
+    test_scan(cache, 0, 9);
+    test_check(cache->shards[0].queueSizes[1] == 2);
+    test_check(!test_cached(cache, "scan:0"));
+
+    test_scan(cache, 9, 32);
+    test_check(test_cached(cache, "a"));
+    test_check(test_cached(cache, "b"));
+    test_check(test_cached(cache, "scan:40"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// S3-FIFO inserts a request evicted from the small queue straight into the main one
+static void test_s3fifo_ghost()
+{
+    lruCache_t *cache = test_cache(10, 1, &s3FifoPolicy, false);
+
+    test_scan(cache, 0, 11);
+    test_check(!test_cached(cache, "scan:0"));
+    test_check(cache->shards[0].queueSizes[1] == 0);
+
+    test_insert(cache, "scan:0", 0);
+    test_check(test_cached(cache, "scan:0"));
+    test_check(cache->shards[0].queueSizes[1] == 1);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_arc_scan();
+    test_arc_ghost();
+    test_s3fifo_scan();
+    test_s3fifo_ghost();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,98 @@
+/*
+ * [meteoserver]
+ * test_recency.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the recency buffer: hits served without the shard lock have to reach the eviction
+ * policy even when their thread serves fewer than RECENCY_BUFFER_SIZE of them.
+ */
+
+
+/**
+* @brief Fills a one-shard LRU cache with 'a' to 'd' and hits 'a', which becomes the least recently
+*        used element unless its hit is applied.
+* @return Cache with the pending hit.
+*/
+static lruCache_t *test_pending_hit();
+
+/**
+* @brief A hit applied when its thread goes idle protects its element from the next eviction.
+*/
+static void test_idle_drain();
+
+/**
+* @brief A hit applied once it's RECENCY_FLUSH_MS old protects its element from the next eviction.
+*/
+static void test_timed_drain();
+
+
+
+/* Definitions */
+
+
+// Fills a one-shard LRU cache and hits its least recently used element
+static lruCache_t *test_pending_hit()
+{
+    lruCache_t *cache = test_cache(4, 1, &lruPolicy, false);
+
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_insert(cache, "c", 0);
+    test_insert(cache, "d", 0);
+    test_check(test_cached(cache, "a"));
+
+    return cache;
+}
+
+// A hit applied when its thread goes idle protects its element from the next eviction
+static void test_idle_drain()
+{
+    lruCache_t *cache = test_pending_hit();
+
+    lru_cache_drain_recency(cache);
+    test_insert(cache, "e", 0);
+
+    test_check(test_cached(cache, "a"));
+    test_check(!test_cached(cache, "b"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// A hit applied once it's RECENCY_FLUSH_MS old protects its element from the next eviction
+static void test_timed_drain()
+{
+    lruCache_t *cache = test_pending_hit();
+
+    usleep((RECENCY_FLUSH_MS + 20) * 1000);
+    test_check(test_cached(cache, "c"));
+    test_insert(cache, "e", 0);
+
+    test_check(test_cached(cache, "a"));
+    test_check(!test_cached(cache, "b"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_idle_drain();
+    test_timed_drain();
+    epoch_free_all();
+
+    return test_result();
+}
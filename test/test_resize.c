@@ -0,0 +1,171 @@
+/*
+ * [meteoserver]
+ * test_resize.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+#include <sys/resource.h>
+
+
+/*
+ * Tests of the resize of the cache at runtime: a shrink only changes the limits of the shards,
+ * and lru_cache_trim evicts the elements over them in batches. A cache grows up to the pools
+ * reserved when it was created, CACHE_RESIZE_HEADROOM times its initial capacity, or only its
+ * initial capacity when they're backed by reserved huge pages.
+ */
+
+
+/**
+* @brief A shrunk cache is trimmed down to its new capacity, keeping the most recent elements.
+*/
+static void test_shrink();
+
+/**
+* @brief A grown cache holds more elements, up to the pools reserved for it.
+*/
+static void test_grow();
+
+/**
+* @brief A cache asking for huge pages falls back to other pages, and one that can't be mapped isn't built.
+*/
+static void test_huge_pages();
+
+/**
+* @brief Inserts a number of requests.
+* @param cache Cache where the requests are inserted.
+* @param count Number of requests.
+*/
+static void test_fill(lruCache_t *cache, int count);
+
+
+
+/* Definitions */
+
+
+// Inserts a number of requests
+static void test_fill(lruCache_t *cache, int count)
+{
+    char request[32];
+
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(request, sizeof(request), "request:%d", i);
+        test_insert(cache, request, 0);
+    }
+}
+
+// A shrunk cache is trimmed down to its new capacity, keeping the most recent elements
+static void test_shrink()
+{
+    lruCache_t  *cache = test_cache(1024, 4, &lruPolicy, false);
+    size_t      filled;
+    size_t      elements;
+    size_t      bytes;
+
+    // Shards evict on their own when they fill, so the cache may hold a few less elements
+    test_fill(cache, 1024);
+    lru_cache_usage(cache, &filled, &bytes);
+    test_check(filled > 768);
+
+    // Nothing is evicted until the cache is trimmed, one batch per shard and pass
+    test_check(lru_cache_resize(cache, 64, 0) == 64);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == filled);
+
+    test_check(lru_cache_trim(cache));
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements >= filled - 4 * CACHE_EVICT_BATCH && elements > 64);
+    while (lru_cache_trim(cache));
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 64);
+    test_check(test_cached(cache, "request:1023"));
+    test_check(!test_cached(cache, "request:0"));
+
+    test_fill(cache, 2048);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 64);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// A grown cache holds more elements, up to the pools reserved for it
+static void test_grow()
+{
+    lruCache_t  *cache = test_cache(64, 4, &lruPolicy, false);
+    size_t      elements;
+    size_t      bytes;
+
+    test_check(lru_cache_resize(cache, 128, 0) == 128);
+    test_check(!lru_cache_trim(cache));
+    test_fill(cache, 512);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 128);
+
+    test_check(lru_cache_resize(cache, 1 << 20, 0) == 64 * CACHE_RESIZE_HEADROOM);
+    test_fill(cache, 1024);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 64 * CACHE_RESIZE_HEADROOM);
+    test_check(test_cached(cache, "request:1023"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// A cache asking for huge pages falls back to other pages, and one that can't be mapped isn't built
+static void test_huge_pages()
+{
+    arguments_t     settings = {0};
+    lruCache_t      *cache;
+    struct rlimit   limit;
+    size_t          grown;
+    size_t          elements;
+    size_t          bytes;
+
+    settings.cacheSize = 64;
+    settings.shardNumber = 4;
+    settings.policy = &lruPolicy;
+    settings.hugePages = true;
+    cache = lru_cache_init(&settings);
+    test_check(cache != NULL);
+    if (cache == NULL)
+        return;
+
+    // Reserved huge pages only hold the initial capacity, the other backings have room to grow
+    grown = cache->pageBacking == CACHE_PAGES_EXPLICIT ? 64 : 64 * CACHE_RESIZE_HEADROOM;
+    test_check(lru_cache_resize(cache, 1 << 20, 0) == grown);
+    test_fill(cache, 1024);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == cache->totalCapacity);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+
+    // Without address space left for its pools, the cache fails instead of its first insert
+    getrlimit(RLIMIT_AS, &limit);
+    setrlimit(RLIMIT_AS, &(struct rlimit){.rlim_cur = 1 << 30, .rlim_max = limit.rlim_max});
+    settings.cacheSize = 1 << 28;
+    cache = lru_cache_init(&settings);
+    setrlimit(RLIMIT_AS, &limit);
+    test_check(cache == NULL);
+    if (cache)
+        test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_shrink();
+    test_grow();
+    test_huge_pages();
+    epoch_free_all();
+
+    return test_result();
+}
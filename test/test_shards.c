@@ -0,0 +1,203 @@
+/*
+ * [meteoserver]
+ * test_shards.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the shards of the cache: the capacity is split between them with no element lost,
+ * requests are spread over all of them, and threads inserting and looking up requests at the
+ * same time, each shard under its own lock, find every request they cached.
+ */
+
+
+/* Arguments of the threads of the concurrent test */
+typedef struct          shardsArgs
+{
+    lruCache_t          *cache;
+    int                 thread;
+    bool                inserted;
+    bool                found;
+}                       shardsArgs_t;
+
+
+/**
+* @brief The capacity is split between the shards, spreading the remainder over the first ones.
+*/
+static void test_split();
+
+/**
+* @brief There are never more shards than elements, nor a cache without both.
+*/
+static void test_clamp();
+
+/**
+* @brief Requests are spread over every shard, and each one is found in the shard it was cached in.
+*/
+static void test_spread();
+
+/**
+* @brief Threads inserting and looking up requests at the same time find every request they cached.
+*/
+static void test_concurrent();
+
+/**
+* @brief Inserts requests of its own, looking each one up right after, and then all of them again.
+* @param args Arguments of the thread.
+*/
+static void *test_worker(void *args);
+
+
+
+/* Definitions */
+
+
+// The capacity is split between the shards, spreading the remainder over the first ones
+static void test_split()
+{
+    arguments_t settings = {0};
+    lruCache_t  *cache;
+    size_t      capacity = 0;
+    size_t      bytes = 0;
+
+    settings.cacheSize = 103;
+    settings.shardNumber = 10;
+    settings.cacheBytes = 100005;
+    settings.policy = &lruPolicy;
+    cache = lru_cache_init(&settings);
+
+    test_check(cache->shardNumber == 10 && cache->totalCapacity == 103);
+    for (size_t i = 0; i < cache->shardNumber; i++)
+    {
+        test_check(cache->shards[i].totalCapacity == (i < 3 ? 11 : 10));
+        test_check(cache->shards[i].byteCapacity == (i < 5 ? 10001 : 10000));
+        capacity += cache->shards[i].totalCapacity;
+        bytes += cache->shards[i].byteCapacity;
+    }
+    test_check(capacity == 103 && bytes == 100005);
+
+    test_free(cache);
+}
+
+// There are never more shards than elements, nor a cache without both
+static void test_clamp()
+{
+    lruCache_t *cache = test_cache(5, 16, &lruPolicy, false);
+
+    test_check(cache->shardNumber == 5);
+    for (size_t i = 0; i < cache->shardNumber; i++)
+        test_check(cache->shards[i].totalCapacity == 1);
+    test_free(cache);
+
+    test_check(test_cache(0, 4, &lruPolicy, false) == NULL);
+    test_check(test_cache(4, 0, &lruPolicy, false) == NULL);
+}
+
+// Requests are spread over every shard, and each one is found in the shard it was cached in
+static void test_spread()
+{
+    lruCache_t  *cache = test_cache(16 * 1024, 16, &lruPolicy, false);
+    char        request[64];
+    size_t      elements;
+    size_t      bytes;
+    bool        found = true;
+
+    for (int i = 0; i < 8 * 1024; i++)
+    {
+        snprintf(request, sizeof(request), "shards:%d", i);
+        test_insert(cache, request, 0);
+    }
+
+    // Each shard holds up to 1024 elements, and gets 512 of the requests on average
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 8 * 1024);
+    for (size_t i = 0; i < cache->shardNumber; i++)
+        test_check(cache->shards[i].currentCapacity > 384 && cache->shards[i].currentCapacity < 640);
+
+    for (int i = 0; i < 8 * 1024; i++)
+    {
+        snprintf(request, sizeof(request), "shards:%d", i);
+        found &= test_cached(cache, request);
+    }
+    test_check(found);
+
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Inserts requests of its own, looking each one up right after, and then all of them again
+static void *test_worker(void *arg)
+{
+    shardsArgs_t    *args = (shardsArgs_t *)arg;
+    char            request[64];
+
+    args->inserted = true;
+    args->found = true;
+    for (int i = 0; i < 4096; i++)
+    {
+        snprintf(request, sizeof(request), "thread:%d:%d", args->thread, i);
+        args->inserted &= test_insert(args->cache, request, 0);
+        args->found &= test_cached(args->cache, request);
+    }
+    for (int i = 0; i < 4096; i++)
+    {
+        snprintf(request, sizeof(request), "thread:%d:%d", args->thread, i);
+        args->found &= test_cached(args->cache, request);
+    }
+
+    lru_cache_drain_recency(args->cache);
+    epoch_unregister();
+    cache_stats_unregister();
+    return NULL;
+}
+
+// Threads inserting and looking up requests at the same time find every request they cached
+static void test_concurrent()
+{
+    lruCache_t      *cache = test_cache(2 * 8 * 4096, 16, &lruPolicy, false);
+    shardsArgs_t    args[8];
+    pthread_t       workers[8];
+    size_t          elements;
+    size_t          bytes;
+
+    // Shards have room enough for their share of the requests to never evict any
+    for (int i = 0; i < 8; i++)
+    {
+        args[i] = (shardsArgs_t){.cache = cache, .thread = i};
+        pthread_create(&(workers[i]), NULL, test_worker, &(args[i]));
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        pthread_join(workers[i], NULL);
+        test_check(args[i].inserted && args[i].found);
+    }
+
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 8 * 4096);
+    test_check(bytes == 8 * 4096 * lru_entry_size(strlen("thread:0:0")));
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_split();
+    test_clamp();
+    test_spread();
+    test_concurrent();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,167 @@
+/*
+ * [meteoserver]
+ * test_snapshot.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the snapshots of the cache: a restored cache holds the elements saved, with their
+ * digests, expirations and recency, and a file that isn't a snapshot is refused.
+ */
+
+
+/**
+* @brief A snapshot restores the unexpired elements, the most recent ones last, freeing what they evict.
+*/
+static void test_round_trip();
+
+/**
+* @brief A snapshot is loaded into a cache with another number of shards, counting only the elements inserted.
+*/
+static void test_rehash();
+
+/**
+* @brief A missing snapshot restores nothing, and a corrupted one is refused.
+*/
+static void test_invalid();
+
+
+
+/* Definitions */
+
+
+// A snapshot restores the unexpired elements, the most recent ones last
+static void test_round_trip()
+{
+    lruCache_t  *cache = test_cache(256, 1, &lruPolicy, false);
+    char        path[PATH_MAX];
+    char        request[64];
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint64_t    expiry;
+    size_t      restored;
+
+    snprintf(path, sizeof(path), "/tmp/test_snapshot.%d", getpid());
+
+    // Requests too long to be stored inside their nodes are freed through the epoch when evicted
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(request, sizeof(request), "snapshot:%d:%s", i, i % 2 ? "longer than an inline key" : "");
+        test_insert(cache, request, 0);
+    }
+    test_insert(cache, "ttl", 100);
+    md5Digest("expired", md5);
+    lru_cache_restore_node(cache, "expired", lru_hash_request("expired"), md5, lru_clock_ms() + 1);
+    usleep(10 * 1000);
+
+    test_check(cache_snapshot_save(cache, path));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+
+    // The smaller cache only keeps the last elements of the file
+    cache = test_cache(16, 1, &lruPolicy, false);
+    test_check(cache_snapshot_load(cache, path, &restored));
+    test_check(restored == 201);
+    test_check(epoch_thread()->retiredCount < EPOCH_RECLAIM_THRESHOLD);
+
+    test_check(!test_cached(cache, "expired"));
+    test_check(!test_cached(cache, "snapshot:0:"));
+    test_check(test_cached(cache, "snapshot:198:"));
+    test_check(test_cached(cache, "snapshot:199:longer than an inline key"));
+    test_check(lru_cache_get_element(cache, "ttl", lru_hash_request("ttl"), md5, &expiry));
+    test_check(expiry > lru_clock_ms() + 99 * 1000 && expiry <= lru_clock_ms() + 100 * 1000);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    unlink(path);
+}
+
+// A snapshot is loaded into a cache with another number of shards, counting only the elements inserted
+static void test_rehash()
+{
+    arguments_t settings = {0};
+    lruCache_t  *cache = test_cache(64, 4, &lruPolicy, false);
+    char        path[PATH_MAX];
+    char        request[2048];
+    char        padding[1800] = {0};
+    size_t      restored;
+
+    // Long requests take more than the whole byte budget of the cache they're loaded into
+    snprintf(path, sizeof(path), "/tmp/test_snapshot.%d", getpid());
+    memset(padding, 'x', sizeof(padding) - 1);
+    for (int i = 0; i < 32; i++)
+    {
+        snprintf(request, sizeof(request), "rehash:%d:%s", i, i % 2 ? padding : "");
+        test_insert(cache, request, 0);
+    }
+    test_check(cache_snapshot_save(cache, path));
+    test_free(cache);
+
+    // The budget holds every short request but none of the long ones, and the cached one isn't restored twice
+    settings.cacheSize = 64;
+    settings.shardNumber = 1;
+    settings.cacheBytes = 16 * lru_entry_size(16);
+    settings.policy = &lruPolicy;
+    cache = lru_cache_init(&settings);
+    test_insert(cache, "rehash:0:", 0);
+    test_check(cache_snapshot_load(cache, path, &restored));
+    test_check(restored == 15);
+    for (int i = 0; i < 32; i += 2)
+    {
+        snprintf(request, sizeof(request), "rehash:%d:", i);
+        test_check(test_cached(cache, request));
+    }
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    unlink(path);
+}
+
+// A missing snapshot restores nothing, and a corrupted one is refused
+static void test_invalid()
+{
+    lruCache_t  *cache = test_cache(16, 1, &lruPolicy, false);
+    char        path[PATH_MAX];
+    size_t      restored = 1;
+    int         fd;
+
+    snprintf(path, sizeof(path), "/tmp/test_snapshot.%d", getpid());
+    unlink(path);
+    test_check(cache_snapshot_load(cache, path, &restored));
+    test_check(restored == 0);
+
+    test_insert(cache, "a", 0);
+    test_check(cache_snapshot_save(cache, path));
+    fd = open(path, O_WRONLY);
+    test_check(fd >= 0 && pwrite(fd, "not a snapshot", 14, 0) == 14);
+    close(fd);
+    test_check(!cache_snapshot_load(cache, path, &restored));
+
+    // So is a snapshot cut in the middle of an element
+    test_check(cache_snapshot_save(cache, path));
+    test_check(truncate(path, sizeof(snapshotHeader_t) + sizeof(snapshotEntry_t)) == 0);
+    test_check(!cache_snapshot_load(cache, path, &restored));
+    test_check(restored == 0);
+    test_free(cache);
+    unlink(path);
+}
+
+
+/* main */
+
+int main()
+{
+    test_round_trip();
+    test_rehash();
+    test_invalid();
+    epoch_free_all();
+
+    return test_result();
+}
@@ -0,0 +1,196 @@
+/*
+ * [meteoserver]
+ * test_stats.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the statistics of the cache: each operation is counted once in the record of its
+ * thread, every thread running at the same time writes to a cache line of its own, and the
+ * records are added up on read, keeping the counts of the threads that already finished.
+ */
+
+
+/* Arguments of the threads of the concurrent test */
+typedef struct          statsArgs
+{
+    lruCache_t          *cache;
+    pthread_barrier_t   *barrier;
+    cacheStats_t        *record;
+}                       statsArgs_t;
+
+
+/**
+* @brief Hits, misses, inserts, evictions and rejections are each counted once.
+*/
+static void test_counts();
+
+/**
+* @brief Records fill whole cache lines, and every running thread writes to its own one.
+*/
+static void test_records();
+
+/**
+* @brief The counts of every thread are added up, even once the thread has finished.
+*/
+static void test_aggregated();
+
+/**
+* @brief Looks up 1000 cached requests and 500 missing ones, while the other threads are running.
+* @param args Arguments of the thread.
+*/
+static void *test_worker(void *args);
+
+
+
+/* Definitions */
+
+
+// Hits, misses, inserts, evictions and rejections are each counted once
+static void test_counts()
+{
+    lruCache_t      *cache = test_cache(4, 1, &lruPolicy, false);
+    cacheStats_t    before;
+    cacheStats_t    after;
+
+    cache_stats_read(&before);
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_insert(cache, "c", 0);
+    test_insert(cache, "d", 0);
+    test_insert(cache, "e", 0);
+    test_insert(cache, "e", 0);
+    test_cached(cache, "e");
+    test_cached(cache, "d");
+    test_cached(cache, "a");
+    cache_stats_read(&after);
+
+    test_check(after.inserts - before.inserts == 5);
+    test_check(after.evictions - before.evictions == 1);
+    test_check(after.hits - before.hits == 2);
+    test_check(after.misses - before.misses == 1);
+    test_check(after.rejections == before.rejections);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+
+    // New requests are rejected by a full cache whose victims are more frequent
+    cache = test_cache(1, 1, &lruPolicy, true);
+    test_insert(cache, "frequent", 0);
+    test_insert(cache, "frequent", 0);
+    cache_stats_read(&before);
+    test_check(!test_insert(cache, "new", 0));
+    cache_stats_read(&after);
+    test_check(after.rejections - before.rejections == 1);
+    test_check(after.inserts == before.inserts && after.evictions == before.evictions);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Looks up 1000 cached requests and 500 missing ones, while the other threads are running
+static void *test_worker(void *arg)
+{
+    statsArgs_t *args = (statsArgs_t *)arg;
+
+    args->record = cache_stats_thread();
+    for (int i = 0; i < 1000; i++)
+        test_cached(args->cache, "cached");
+    for (int i = 0; i < 500; i++)
+        test_cached(args->cache, "missing");
+
+    lru_cache_drain_recency(args->cache);
+    pthread_barrier_wait(args->barrier);
+    epoch_unregister();
+    cache_stats_unregister();
+    return NULL;
+}
+
+// Records fill whole cache lines, and every running thread writes to its own one
+static void test_records()
+{
+    lruCache_t          *cache = test_cache(16, 1, &lruPolicy, false);
+    statsArgs_t         args[8];
+    pthread_t           workers[8];
+    pthread_barrier_t   barrier;
+    cacheStats_t        before;
+    cacheStats_t        after;
+
+    test_check(sizeof(cacheStats_t) % CACHE_LINE_SIZE == 0);
+    test_check((uintptr_t)cache_stats_thread() % CACHE_LINE_SIZE == 0);
+    test_check(cache_stats_thread() == cache_stats_thread());
+
+    // No thread gives its record back until all of them have taken theirs
+    test_insert(cache, "cached", 0);
+    pthread_barrier_init(&barrier, NULL, 8);
+    cache_stats_read(&before);
+    for (int i = 0; i < 8; i++)
+    {
+        args[i] = (statsArgs_t){.cache = cache, .barrier = &barrier};
+        pthread_create(&(workers[i]), NULL, test_worker, &(args[i]));
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        pthread_join(workers[i], NULL);
+        test_check(args[i].record != cache_stats_thread());
+        test_check((uintptr_t)args[i].record % CACHE_LINE_SIZE == 0);
+        for (int j = 0; j < i; j++)
+            test_check(args[i].record != args[j].record);
+    }
+    cache_stats_read(&after);
+    test_check(after.hits - before.hits == 8 * 1000);
+    test_check(after.misses - before.misses == 8 * 500);
+
+    pthread_barrier_destroy(&barrier);
+    test_free(cache);
+}
+
+// The counts of every thread are added up, even once the thread has finished
+static void test_aggregated()
+{
+    lruCache_t          *cache = test_cache(16, 1, &lruPolicy, false);
+    statsArgs_t         args;
+    pthread_t           worker;
+    pthread_barrier_t   barrier;
+    cacheStats_t        before;
+    cacheStats_t        after;
+
+    test_insert(cache, "cached", 0);
+    pthread_barrier_init(&barrier, NULL, 1);
+    cache_stats_read(&before);
+
+    // Each thread claims a record given back by a previous one, keeping its counts
+    for (int i = 0; i < 4; i++)
+    {
+        args = (statsArgs_t){.cache = cache, .barrier = &barrier};
+        pthread_create(&worker, NULL, test_worker, &args);
+        pthread_join(worker, NULL);
+    }
+    cache_stats_read(&after);
+    test_check(after.hits - before.hits == 4 * 1000);
+    test_check(after.misses - before.misses == 4 * 500);
+
+    pthread_barrier_destroy(&barrier);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_counts();
+    test_records();
+    test_aggregated();
+    epoch_free_all();
+
+    return test_result();
+}
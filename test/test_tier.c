@@ -0,0 +1,183 @@
+/*
+ * [meteoserver]
+ * test_tier.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the disk tier: the victims of the cache, evicted by an insert or by a shrink, are
+ * demoted to it and taken out when they're promoted, and emptying it for a new cache drops the
+ * demotions of the flushed one.
+ */
+
+
+/**
+* @brief Evicted elements are found in the tier once, with their digests.
+*/
+static void test_demotion();
+
+/**
+* @brief The elements evicted when a cache is shrunk are demoted like the victims of an insert.
+*/
+static void test_shrink();
+
+/**
+* @brief A demotion of a flushed cache is dropped, while the ones of the new cache are kept.
+*/
+static void test_flush();
+
+/**
+* @brief Opens a disk tier in a temporary file.
+* @param path Filled with the path of the file.
+* @return Disk tier.
+*/
+static diskTier_t *test_tier(char *path);
+
+
+
+/* Definitions */
+
+
+// Opens a disk tier in a temporary file
+static diskTier_t *test_tier(char *path)
+{
+    snprintf(path, PATH_MAX, "/tmp/test_tier.%d", getpid());
+    return disk_tier_open(path, 1 << 20);
+}
+
+// Evicted elements are found in the tier once, with their digests
+static void test_demotion()
+{
+    lruCache_t  *cache = test_cache(4, 1, &lruPolicy, false);
+    char        path[PATH_MAX];
+    diskTier_t  *tier = test_tier(path);
+    char        request[DISK_TIER_KEY_SIZE + 2];
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint8_t     expected[MD5_DIGEST_SIZE];
+    uint64_t    expiry = 1;
+
+    test_check(tier != NULL);
+    cache->diskTier = tier;
+    test_insert(cache, "a", 0);
+    test_insert(cache, "b", 0);
+    test_insert(cache, "c", 0);
+    test_insert(cache, "d", 0);
+    test_insert(cache, "e", 0);
+
+    // 'a' only lives in the tier, until it's promoted
+    test_check(!test_cached(cache, "a"));
+    md5Digest("a", expected);
+    test_check(disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+    test_check(!memcmp(md5, expected, MD5_DIGEST_SIZE) && expiry == 0);
+    test_check(!disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+    test_check(!disk_tier_take(tier, "b", lru_hash_request("b"), md5, &expiry));
+
+    // Long requests don't fit in a slot
+    memset(request, 'x', DISK_TIER_KEY_SIZE + 1);
+    request[DISK_TIER_KEY_SIZE + 1] = '\0';
+    test_insert(cache, request, 0);
+    test_insert(cache, "f", 0);
+    test_insert(cache, "g", 0);
+    test_insert(cache, "h", 0);
+    test_insert(cache, "i", 0);
+    test_check(!test_cached(cache, request));
+    test_check(!disk_tier_take(tier, request, lru_hash_request(request), md5, &expiry));
+    test_check(disk_tier_take(tier, "b", lru_hash_request("b"), md5, &expiry));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    disk_tier_close(tier);
+    unlink(path);
+}
+
+// The elements evicted when a cache is shrunk are demoted like the victims of an insert
+static void test_shrink()
+{
+    lruCache_t  *cache = test_cache(64, 1, &lruPolicy, false);
+    char        path[PATH_MAX];
+    diskTier_t  *tier = test_tier(path);
+    char        request[32];
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint8_t     expected[MD5_DIGEST_SIZE];
+    uint64_t    expiry;
+    int         demoted = 0;
+
+    cache->diskTier = tier;
+    for (int i = 0; i < 64; i++)
+    {
+        snprintf(request, sizeof(request), "shrink:%d", i);
+        test_insert(cache, request, 0);
+    }
+    lru_cache_drain_recency(cache);
+    test_check(lru_cache_resize(cache, 8, 0) == 8);
+    while (lru_cache_trim(cache));
+
+    // The 56 least recently used elements left the cache for the tier, and the rest stayed
+    for (int i = 0; i < 56; i++)
+    {
+        snprintf(request, sizeof(request), "shrink:%d", i);
+        md5Digest(request, expected);
+        demoted += disk_tier_take(tier, request, lru_hash_request(request), md5, &expiry) &&
+                   !memcmp(md5, expected, MD5_DIGEST_SIZE);
+    }
+    test_check(demoted == 56);
+    test_check(test_cached(cache, "shrink:56") && test_cached(cache, "shrink:63"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+    disk_tier_close(tier);
+    unlink(path);
+}
+
+// A demotion of a flushed cache is dropped, while the ones of the new cache are kept
+static void test_flush()
+{
+    char            path[PATH_MAX];
+    diskTier_t      *tier = test_tier(path);
+    diskTierSlot_t  slot;
+    uint8_t         md5[MD5_DIGEST_SIZE];
+    uint64_t        expiry;
+
+    md5Digest("a", md5);
+    test_check(disk_tier_stage(&slot, "a", 1, lru_hash_request("a"), md5, 0));
+    disk_tier_put(tier, &slot, 1);
+    test_check(disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+
+    // The victim of the old cache was staged before the flush, and is demoted after it
+    disk_tier_put(tier, &slot, 1);
+    disk_tier_clear(tier, 2);
+    test_check(!disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+    disk_tier_put(tier, &slot, 1);
+    test_check(!disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+    disk_tier_put(tier, &slot, 2);
+    test_check(disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+
+    // An element that expires in the tier is taken out as well
+    test_check(disk_tier_stage(&slot, "a", 1, lru_hash_request("a"), md5, lru_clock_ms() + 10));
+    disk_tier_put(tier, &slot, 2);
+    usleep(20 * 1000);
+    test_check(!disk_tier_take(tier, "a", lru_hash_request("a"), md5, &expiry));
+    disk_tier_close(tier);
+    unlink(path);
+}
+
+
+/* main */
+
+int main()
+{
+    test_demotion();
+    test_shrink();
+    test_flush();
+    epoch_free_all();
+
+    return test_result();
+}
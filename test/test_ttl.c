@@ -0,0 +1,153 @@
+/*
+ * [meteoserver]
+ * test_ttl.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the expiration of the elements: expired elements are misses as soon as their TTL
+ * passes, and the timing wheel evicts them once its ticks are swept. Elements are restored
+ * with expirations in milliseconds, so the tests don't wait for whole seconds.
+ */
+
+
+/**
+* @brief An expired element is a miss before the wheel evicts it, and can be inserted again.
+*/
+static void test_lazy_expiry();
+
+/**
+* @brief Sweeping the wheel evicts the expired elements, and only them.
+*/
+static void test_sweep();
+
+/**
+* @brief Elements inserted without a TTL take the default one of the cache.
+*/
+static void test_default_ttl();
+
+/**
+* @brief Restores a request with its digest and an expiration a number of milliseconds from now.
+* @param cache Cache where the request is restored.
+* @param request Request to be restored.
+* @param ms Milliseconds until it expires.
+*/
+static void test_restore(lruCache_t *cache, char *request, uint64_t ms);
+
+
+
+/* Definitions */
+
+
+// Restores a request with its digest and an expiration a number of milliseconds from now
+static void test_restore(lruCache_t *cache, char *request, uint64_t ms)
+{
+    uint8_t md5[MD5_DIGEST_SIZE];
+
+    md5Digest(request, md5);
+    lru_cache_restore_node(cache, request, lru_hash_request(request), md5, lru_clock_ms() + ms);
+}
+
+// An expired element is a miss before the wheel evicts it, and can be inserted again
+static void test_lazy_expiry()
+{
+    lruCache_t  *cache = test_cache(4, 1, &lruPolicy, false);
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint64_t    expiry;
+    size_t      elements;
+    size_t      bytes;
+
+    test_restore(cache, "a", TTL_WHEEL_TICK_MS / 2);
+    test_check(lru_cache_get_element(cache, "a", lru_hash_request("a"), md5, &expiry));
+    test_check(expiry > lru_clock_ms());
+
+    usleep(TTL_WHEEL_TICK_MS * 1000);
+    test_check(!test_cached(cache, "a"));
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 1);
+
+    // The expired node is reused, and the new element never expires
+    test_insert(cache, "a", 0);
+    test_check(lru_cache_get_element(cache, "a", lru_hash_request("a"), md5, &expiry));
+    test_check(expiry == 0);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 1);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Sweeping the wheel evicts the expired elements, and only them
+static void test_sweep()
+{
+    lruCache_t  *cache = test_cache(64, 4, &lruPolicy, false);
+    char        request[32];
+    size_t      elements;
+    size_t      bytes;
+
+    for (int i = 0; i < 16; i++)
+    {
+        snprintf(request, sizeof(request), "short:%d", i);
+        test_restore(cache, request, TTL_WHEEL_TICK_MS);
+        snprintf(request, sizeof(request), "long:%d", i);
+        test_restore(cache, request, 60 * 1000);
+        snprintf(request, sizeof(request), "never:%d", i);
+        test_insert(cache, request, 0);
+    }
+
+    lru_cache_expire(cache);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 48);
+
+    usleep(3 * TTL_WHEEL_TICK_MS * 1000);
+    lru_cache_expire(cache);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 32);
+    test_check(!test_cached(cache, "short:0"));
+    test_check(test_cached(cache, "long:0"));
+    test_check(test_cached(cache, "never:0"));
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Elements inserted without a TTL take the default one of the cache
+static void test_default_ttl()
+{
+    lruCache_t  *cache = test_cache(4, 1, &lruPolicy, false);
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint64_t    expiry;
+    uint64_t    now = lru_clock_ms();
+
+    cache->defaultTtl = 10;
+    test_insert(cache, "default", 0);
+    test_insert(cache, "own", 100);
+
+    test_check(lru_cache_get_element(cache, "default", lru_hash_request("default"), md5, &expiry));
+    test_check(expiry >= now + 10 * 1000 && expiry < now + 11 * 1000);
+    test_check(lru_cache_get_element(cache, "own", lru_hash_request("own"), md5, &expiry));
+    test_check(expiry >= now + 100 * 1000 && expiry < now + 101 * 1000);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_lazy_expiry();
+    test_sweep();
+    test_default_ttl();
+    epoch_free_all();
+
+    return test_result();
+}
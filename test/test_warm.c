@@ -0,0 +1,210 @@
+/*
+ * [meteoserver]
+ * test_warm.c
+ * October 16, 2026.
+ *
+ * Created by Álvaro Romero <alvromero96@gmail.com>
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General Public
+ * License (version 2) as published by the FSF - Free Software
+ * Foundation.
+ */
+
+#include "test.h"
+
+
+/*
+ * Tests of the warm-up of the cache from a list of keys: every valid key is cached once with
+ * the default TTL, only the keys actually inserted are counted, and the warm-up threads give
+ * their epoch and statistics records back, so the server can warm up any number of times.
+ */
+
+
+/**
+* @brief Every valid key of the list is cached and counted once, and invalid lines are skipped.
+*/
+static void test_keys();
+
+/**
+* @brief Keys over the byte budget of their shard aren't counted, and the admission filter is skipped.
+*/
+static void test_rejected();
+
+/**
+* @brief Warming up more times than thread records there are reuses the records of the finished threads.
+*/
+static void test_threads();
+
+/**
+* @brief Writes a list of keys to a temporary file.
+* @param path Filled with the path of the file.
+* @param keys Contents of the file.
+*/
+static void test_list(char *path, char *keys);
+
+/**
+* @brief Writes a list of numbered keys, long enough to be allocated, to a temporary file.
+* @param path Filled with the path of the file.
+* @param count Number of keys.
+*/
+static void test_numbered_list(char *path, int count);
+
+
+
+/* Definitions */
+
+
+// Writes a list of keys to a temporary file
+static void test_list(char *path, char *keys)
+{
+    FILE *file;
+
+    snprintf(path, PATH_MAX, "/tmp/test_warm.%d", getpid());
+    file = fopen(path, "w");
+    fputs(keys, file);
+    fclose(file);
+}
+
+// Writes a list of numbered keys, long enough to be allocated, to a temporary file
+static void test_numbered_list(char *path, int count)
+{
+    FILE *file;
+
+    snprintf(path, PATH_MAX, "/tmp/test_warm.%d", getpid());
+    file = fopen(path, "w");
+    for (int i = 0; i < count; i++)
+        fprintf(file, "warm:request:with:a:long:key:%d\n", i);
+    fclose(file);
+}
+
+// Every valid key of the list is cached and counted once, and invalid lines are skipped
+static void test_keys()
+{
+    lruCache_t  *cache = test_cache(256, 4, &lruPolicy, false);
+    char        path[PATH_MAX];
+    char        *keys = calloc(1, 64 * 1024);
+    char        *tooLong = calloc(1, MAXREQUESTSIZE + 2);
+    char        request[64];
+    uint8_t     md5[MD5_DIGEST_SIZE];
+    uint64_t    expiry = 0;
+    size_t      warmed;
+    size_t      elements;
+    size_t      bytes;
+
+    // 100 keys, 20 of them repeated, a key ending in '\r\n', empty lines and a key too long
+    memset(tooLong, 'x', MAXREQUESTSIZE + 1);
+    for (int i = 0; i < 120; i++)
+        sprintf(keys + strlen(keys), "warm:%d\n\n", i % 100);
+    strcat(keys, "windows\r\n");
+    strcat(keys, tooLong);
+    strcat(keys, "\nlast");
+    test_list(path, keys);
+
+    cache->defaultTtl = 60;
+    test_check(cache_warm(cache, path, 4, &warmed));
+    test_check(warmed == 102);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 102);
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(request, sizeof(request), "warm:%d", i);
+        test_check(test_cached(cache, request));
+    }
+    test_check(test_cached(cache, "windows") && test_cached(cache, "last"));
+    test_check(!test_cached(cache, "windows\r") && !test_cached(cache, ""));
+
+    // Warmed keys expire with the default TTL
+    test_check(lru_cache_get_element(cache, "last", lru_hash_request("last"), md5, &expiry));
+    test_check(expiry > lru_clock_ms() && expiry <= lru_clock_ms() + 60 * 1000);
+
+    // Warming up the same list again inserts nothing
+    test_check(cache_warm(cache, path, 4, &warmed));
+    test_check(warmed == 0);
+    test_check(!cache_warm(cache, "/nonexistent/test_warm", 4, &warmed));
+
+    unlink(path);
+    free(keys);
+    free(tooLong);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Keys over the byte budget of their shard aren't counted, and the admission filter is skipped
+static void test_rejected()
+{
+    arguments_t settings = {0};
+    lruCache_t  *cache;
+    char        path[PATH_MAX];
+    size_t      warmed;
+    size_t      elements;
+    size_t      bytes;
+
+    settings.cacheSize = 16;
+    settings.shardNumber = 1;
+    settings.cacheBytes = lru_entry_size(16);
+    settings.policy = &lruPolicy;
+    cache = lru_cache_init(&settings);
+
+    test_list(path, "a\nwarm:request:over:the:budget\nb\n");
+    test_check(cache_warm(cache, path, 1, &warmed));
+    test_check(warmed == 2);
+    test_check(test_cached(cache, "b"));
+    unlink(path);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+
+    // A full cache filtered by TinyLFU would reject most keys, never seen before
+    cache = test_cache(16, 1, &lruPolicy, true);
+    test_numbered_list(path, 64);
+    test_check(cache_warm(cache, path, 1, &warmed));
+    test_check(warmed == 64);
+    lru_cache_usage(cache, &elements, &bytes);
+    test_check(elements == 16);
+    test_check(test_cached(cache, "warm:request:with:a:long:key:63"));
+    unlink(path);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+// Warming up more times than thread records there are reuses the records of the finished threads
+static void test_threads()
+{
+    lruCache_t      *cache = test_cache(16, 4, &lruPolicy, false);
+    char            path[PATH_MAX];
+    cacheStats_t    before;
+    cacheStats_t    after;
+    size_t          warmed;
+    size_t          total = 0;
+    bool            warmedAll = true;
+
+    // Every warm-up evicts the keys of the previous one, retiring their requests
+    test_numbered_list(path, 256);
+    cache_stats_read(&before);
+    for (int i = 0; i < 2 * EPOCH_MAX_THREADS / 8; i++)
+    {
+        warmedAll &= cache_warm(cache, path, 8, &warmed) && warmed == 256;
+        total += warmed;
+    }
+    test_check(warmedAll);
+
+    // No thread shares its statistics record, so no insert is lost
+    cache_stats_read(&after);
+    test_check(after.inserts - before.inserts == total);
+    unlink(path);
+    lru_cache_drain_recency(cache);
+    test_free(cache);
+}
+
+
+/* main */
+
+int main()
+{
+    test_keys();
+    test_rejected();
+    test_threads();
+    epoch_free_all();
+
+    return test_result();
+}